@@ -1,14 +1,30 @@
 #include "Flag_group.h"
+#include <algorithm>
+
+// 整体替换花名册（如花名册服务重新读取数据文件、保存时取快照）
+Flag_group &Flag_group::operator=(const Flag_group &other)
+{
+    TraceScope trace("Flag_group::operator=", "roster");
+    for (int i = 0; i < 4; ++i) {
+        group[i] = other.group[i];
+    }
+    nextId = std::max(nextId, other.nextId); // 替换前后分配过的编号都不会再次分配
+    ++layoutRevision; // 替换进来的队员可能与文件中的记录不对应，下次保存整体重写
+    return *this;
+}
 
 // 添加队员到指定组
 void Flag_group::addPersonToGroup(const Person &person, int groupNumber)
 {
     // 参数：Person类：待添加的队员信息。 int groupNumber：队员对应的组别。
     // 根据组别将新队员person加入到对应的组中
+    TraceScope trace("Flag_group::addPersonToGroup", "roster");
     if (groupNumber >= 1 && groupNumber <= 4) // 判断组号是否合理：1~4对应一至四组
     {
         // 因为group索引最小为0，与输入组号存在一位的差距，需要减一处理
         group[groupNumber - 1].push_back(person);// push_back,添加新队员至对应组
+        assignId(group[groupNumber - 1].back());
+        ++layoutRevision;
     }
     // 测试代码
     // else
@@ -17,11 +33,64 @@ void Flag_group::addPersonToGroup(const Person &person, int groupNumber)
     // }
 }
 
+// 添加队员到指定组，转移person
+void Flag_group::addPersonToGroup(Person &&person, int groupNumber)
+{
+    TraceScope trace("Flag_group::addPersonToGroup", "roster");
+    if (groupNumber >= 1 && groupNumber <= 4)
+    {
+        group[groupNumber - 1].push_back(std::move(person));
+        assignId(group[groupNumber - 1].back());
+        ++layoutRevision;
+    }
+}
+
+// 批量添加队员到指定组
+void Flag_group::addPersonsToGroup(const vector<Person> &persons, int groupNumber)
+{
+    // 参数：vector<Person>：待添加的队员，按顺序追加到组末尾。 int groupNumber：队员对应的组别。
+    // 批量导入时使用，一次预留空间后整体插入，避免逐个push_back时反复扩容
+    TraceScope trace("Flag_group::addPersonsToGroup", "roster");
+    if (groupNumber >= 1 && groupNumber <= 4)
+    {
+        vector<Person> &currentGroup = group[groupNumber - 1];
+        size_t first = currentGroup.size();
+        currentGroup.reserve(currentGroup.size() + persons.size());
+        currentGroup.insert(currentGroup.end(), persons.begin(), persons.end());
+        for (size_t row = first; row < currentGroup.size(); ++row) {
+            assignId(currentGroup[row]);
+        }
+        ++layoutRevision;
+    }
+}
+
+// 批量添加队员到指定组，转移persons中的队员
+void Flag_group::addPersonsToGroup(vector<Person> &&persons, int groupNumber)
+{
+    TraceScope trace("Flag_group::addPersonsToGroup", "roster");
+    if (groupNumber >= 1 && groupNumber <= 4)
+    {
+        vector<Person> &currentGroup = group[groupNumber - 1];
+        size_t first = currentGroup.size();
+        if (currentGroup.empty()) {
+            currentGroup = std::move(persons); // 空组直接接管整个数组，不逐个移动
+        } else {
+            currentGroup.reserve(currentGroup.size() + persons.size());
+            currentGroup.insert(currentGroup.end(), std::make_move_iterator(persons.begin()), std::make_move_iterator(persons.end()));
+        }
+        for (size_t row = first; row < currentGroup.size(); ++row) {
+            assignId(currentGroup[row]);
+        }
+        ++layoutRevision;
+    }
+}
+
 // 从指定组中删除指定的队员
 void Flag_group::removePersonFromGroup(const Person &person, int groupNumber)
 {
     // 参数：Person类：待删除的队员信息。 int groupNumber：队员对应的组别。
     // 将根据参数的groupNumber在对应的组中查找是否存在参数中的person，查找到后，删除队员。
+    TraceScope trace("Flag_group::removePersonFromGroup", "roster");
     if (groupNumber >= 1 && groupNumber <= 4)
     {
         // 因为group索引最小为0，与输入组号存在一位的差距，需要减一处理
@@ -29,10 +98,11 @@ void Flag_group::removePersonFromGroup(const Person &person, int groupNumber)
         // 从对应组中依次查找是否存在要删除的队员
         for (auto it = currentGroup.begin(); it != currentGroup.end(); ++it)
         {
-            if (it->getName() == person.getName() && it->getGender() == person.getGender() && it->getClassname() == person.getClassname())
+            if (*it == person)
             {
-                // 不能通过组名判断person是否是要删除的那个队员，因为在onGroupComboBoxChanged函数中已经更新了person的组别
+                // 按队员编号判断，不能通过组名判断person是否是要删除的那个队员，因为在onGroupComboBoxChanged函数中已经更新了person的组别
                 currentGroup.erase(it);
+                ++layoutRevision;
                 return; // 查找到队员后，终止查找
             }
         }
@@ -46,20 +116,25 @@ void Flag_group::removePersonFromGroup(const Person &person, int groupNumber)
     // }
 }
 
-// 修改指定组中指定姓名的队员信息
-void Flag_group::modifyPersonInGroup(const Person& oldPerson, const Person& newPerson, int groupNumber)
+// 修改指定组中指定队员的信息
+int Flag_group::modifyPersonInGroup(const Person& oldPerson, const Person& newPerson, int groupNumber)
 {
     // 参数：Person类：oldPerson:待修改的队员，newPerson：用于替换原队员信息的新信息。 int groupNumber：队员对应的组别。
     // 将根据参数的groupNumber在对应的组中查找是否存在参数中的person，查找到后，用newPerson中数据替换oldPerson的数据，完成修改
     // 修改组别以外的队员信息，如果是组员修改组别信息将不从此函数进行
+    // 返回值：被修改队员在组内的行号，供队员标签模型只刷新这一行；未找到时返回-1
+    TraceScope trace("Flag_group::modifyPersonInGroup", "roster");
     if (groupNumber >= 1 && groupNumber <= 4) {
         // 因为group索引最小为0，与输入组号存在一位的差距，需要减一处理
         vector<Person>& currentGroup = group[groupNumber - 1];
         // 从对应组中依次查找是否存在待修改的队员
-        for (auto& person : currentGroup) {
-            if (person == oldPerson) {
-                person = newPerson;
-                return;
+        for (size_t row = 0; row < currentGroup.size(); ++row) {
+            if (currentGroup[row] == oldPerson) {
+                Person replaced = currentGroup[row];
+                currentGroup[row] = newPerson;
+                currentGroup[row].setId(replaced.getId()); // 仍是原来那名队员，保留编号，排班历史等引用不受改名影响
+                currentGroup[row].takeRecordOf(replaced); // 仍对应文件中原队员的那条记录
+                return static_cast<int>(row);
             }
         }
         // 测试代码
@@ -70,20 +145,21 @@ void Flag_group::modifyPersonInGroup(const Person& oldPerson, const Person& newP
     // {
     //     std::cerr << "非法组号，所属组名应为1~4" << endl;
     // }
-
+    return -1;
 }
 
-// 在指定组中查找指定姓名的队员
+// 在指定组中查找指定的队员
 Person* Flag_group::findPersonInGroup(const Person &person, int groupNumber)
 {
     // 参数：Person类：待查找的队员信息。 int groupNumber：队员对应的组别。
     // 将根据参数的groupNumber在对应的组中查找是否存在参数中的person，查找到后，返回该队员
+    TraceScope trace("Flag_group::findPersonInGroup", "roster");
     if (groupNumber >= 1 && groupNumber <= 4)
     {
         vector<Person> &currentGroup = group[groupNumber - 1];
         for (auto &tempPerson : currentGroup)
         {
-            if (tempPerson.getName() == person.getName() && tempPerson.getGender() == person.getGender() && tempPerson.getClassname() == person.getClassname())
+            if (tempPerson == person)
             {
                 // 不能通过组名判断person是否是要查找的那个队员，因为在onGroupComboBoxChanged函数中已经更新了person的组别(即切换队员组别功能）
                 return &tempPerson;
@@ -100,7 +176,29 @@ Person* Flag_group::findPersonInGroup(const Person &person, int groupNumber)
     return nullptr;
 }
 
-// 在全队查找指定姓名的队员
+// 在指定组中查找指定的队员所在行
+int Flag_group::indexOfPersonInGroup(const Person &person, int groupNumber) const
+{
+    // 参数：Person类：待查找的队员信息。 int groupNumber：队员对应的组别。
+    // 判定规则与findPersonInGroup、removePersonFromGroup一致（队员编号），返回队员在组内的行号，未找到返回-1
+    // 队员标签模型需要在删除前知道行号，才能发出精确到行的rowsRemoved信号
+    TraceScope trace("Flag_group::indexOfPersonInGroup", "roster");
+    if (groupNumber >= 1 && groupNumber <= 4)
+    {
+        const vector<Person> &currentGroup = group[groupNumber - 1];
+        for (size_t row = 0; row < currentGroup.size(); ++row)
+        {
+            const Person &tempPerson = currentGroup[row];
+            if (tempPerson == person)
+            {
+                return static_cast<int>(row);
+            }
+        }
+    }
+    return -1;
+}
+
+// 在全队查找指定的队员
 Person* Flag_group::findPerson(const Person &person) {
     // 参数：Person类：待查找的队员信息。
     for (int i = 1; i <= 4; ++i) {
@@ -148,3 +246,59 @@ const vector<Person>& Flag_group::getGroupMembers(int groupNumber) const
         return emptyGroup;
     }
 }
+
+// 读取或保存后是否有任何修改
+bool Flag_group::isDirty() const
+{
+    TraceScope trace("Flag_group::isDirty", "roster");
+    if (isLayoutChanged()) {
+        return true;
+    }
+    for (const auto &currentGroup : group) {
+        for (const auto &person : currentGroup) {
+            if (person.isDirty()) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+// 撤销、重做时恢复部分队员
+void Flag_group::restoreMembers(const std::unordered_set<int> &ids, const vector<MemberSlot> &memberSlots)
+{
+    // 参数：ids：要移除的队员编号，包括要恢复的队员与撤销时应当删除的新增队员。 memberSlots：要插回的队员及其位置。
+    TraceScope trace("Flag_group::restoreMembers", "roster");
+    if (!ids.empty()) {
+        for (auto &currentGroup : group) {
+            currentGroup.erase(std::remove_if(currentGroup.begin(), currentGroup.end(),
+                                              [&ids](const Person &member) { return ids.count(member.getId()) > 0; }),
+                               currentGroup.end());
+        }
+    }
+    // 按行号升序插回，前面的队员插回后，后面的队员行号恰好与记录时一致
+    for (const MemberSlot &slot : memberSlots) {
+        if (slot.groupNumber < 1 || slot.groupNumber > 4) {
+            continue;
+        }
+        vector<Person> &currentGroup = group[slot.groupNumber - 1];
+        size_t row = std::min(slot.row, currentGroup.size());
+        assignId(*currentGroup.insert(currentGroup.begin() + row, slot.person));
+    }
+    ++layoutRevision; // 恢复的队员可能与文件中的记录不对应，下次保存整体重写
+}
+// 为队员分配编号
+// 读取文件得到的队员已有编号，只需保证之后新建的队员编号更大；旧版数据文件没有编号，读取时在这里补上
+void Flag_group::assignId(Person &person)
+{
+    if (person.getId() <= 0) {
+        person.setId(nextId++);
+    } else if (person.getId() >= nextId) {
+        nextId = person.getId() + 1;
+    }
+}
+// 读取或保存完成
+void Flag_group::markSaved(long long fileSize, long long savedRevision)
+{
+    savedLayoutRevision = savedRevision;
+    savedFileSize = fileSize;
+}
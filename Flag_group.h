@@ -6,7 +6,11 @@
 #pragma once
 #include<iostream>
 #include<vector>
+#include<utility>
+#include<iterator>
+#include<unordered_set>
 #include"Person.h"
+#include"traceFunction.h"
 using std::vector;
 using std::endl;
 
@@ -14,17 +18,70 @@ class Flag_group
 {
 public:
     Flag_group(){}
+    Flag_group(const Flag_group& other) = default;
+    Flag_group& operator=(const Flag_group& other); // 整体替换（如重新读取数据文件）后各队员与文件中记录的对应关系不再可靠，标记为需要整体重写
     //操作group容器的函数
-    //如果存在重名情况将对同名者的第一个被检索的人进行操作
+    //以队员编号识别队员（见Person::operator==），加入花名册时为还没有编号的队员分配新编号
     void addPersonToGroup(const Person &person, int groupNumber); // 添加队员到指定组
+    void addPersonToGroup(Person &&person, int groupNumber); // 添加队员到指定组，转移person而不复制
+    void addPersonsToGroup(const vector<Person> &persons, int groupNumber); // 批量添加队员到指定组末尾
+    void addPersonsToGroup(vector<Person> &&persons, int groupNumber); // 批量添加队员到指定组末尾，转移persons中的队员
+    // 批量修改指定组的队员：一次遍历，对组内每名队员调用一次edit(Person&)，可同时修改多项信息与执勤时间
+    // 返回被修改队员的行范围（第一行，最后一行），调用者据此只发出一次修改通知；没有队员被修改时返回(-1, -1)
+    template <class Edit>
+    std::pair<int, int> editGroup(int groupNumber, Edit&& edit) {
+        TraceScope trace("Flag_group::editGroup", "roster");
+        std::pair<int, int> changed(-1, -1);
+        if (groupNumber < 1 || groupNumber > 4) {
+            return changed;
+        }
+        vector<Person>& currentGroup = group[groupNumber - 1];
+        for (size_t row = 0; row < currentGroup.size(); ++row) {
+            Person before = currentGroup[row]; // 只复制数据指针，修改后不再共用同一份数据即说明该队员被修改过
+            edit(currentGroup[row]);
+            if (!currentGroup[row].sharesDataWith(before)) {
+                if (changed.first < 0) {
+                    changed.first = static_cast<int>(row);
+                }
+                changed.second = static_cast<int>(row);
+            }
+        }
+        return changed;
+    }
     void removePersonFromGroup(const Person &person, int groupNumber); // 从指定组中删除指定的队员
-    void modifyPersonInGroup(const Person& oldPerson, const Person& newPerson, int groupNumber); // 修改指定组中指定姓名的队员信息
+    int modifyPersonInGroup(const Person& oldPerson, const Person& newPerson, int groupNumber); // 修改指定组中指定队员的信息，返回被修改队员所在行，未找到返回-1
     Person* findPersonInGroup(const Person &person, int groupNumber); // 在指定组中查找指定的队员
-    Person* findPerson(const Person &person); // 在全队查找指定姓名的队员
+    int indexOfPersonInGroup(const Person &person, int groupNumber) const; // 在指定组中查找指定的队员，返回其所在行，未找到返回-1
+    Person* findPerson(const Person &person); // 在全队查找指定的队员
     vector<Person>& getGroupMembers(int groupNumber); // 获取指定组的所有队员，返回可修改引用版本
     const vector<Person>& getGroupMembers(int groupNumber) const; // 获取指定组的所有队员，返回常量版本
+    // 队员在花名册中的位置与当时的信息，撤销记录以此保存被修改的队员
+    struct MemberSlot {
+        int groupNumber; // 组别，1~4
+        size_t row; // 组内行号
+        Person person; // 队员信息，只复制数据指针
+    };
+    // 撤销、重做时恢复部分队员：先移除编号在ids中的队员，再把memberSlots中的队员插回原来的组别与行号
+    // memberSlots须按组别、行号升序排列。队员的顺序和数目可能已改变，下次保存整体重写
+    void restoreMembers(const std::unordered_set<int> &ids, const vector<MemberSlot> &memberSlots);
+
+    // 保存状态，用于跳过无修改的保存、只改写修改过的队员记录
+    bool isDirty() const; // 读取或保存后是否有任何修改
+    bool isLayoutChanged() const { return layoutRevision != savedLayoutRevision; } // 是否增删过队员或整体替换过，文件中记录的顺序和数目已不对应，只能整体重写
+    long long getLayoutRevision() const { return layoutRevision; } // 队员增删、整体替换的次数，后台保存完成时用于判断期间是否又有增删
+    long long getSavedFileSize() const { return savedFileSize; } // 最近一次读取或保存时数据文件的大小，用于发现文件被其他程序改动
+    // 读取或保存完成，清除组级修改标记（队员的标记由文件读写函数逐个清除）
+    // savedRevision：写入文件的是哪一次增删后的花名册，后台保存期间又有增删时仍保持需要整体重写
+    void markSaved(long long fileSize, long long savedRevision);
+    void markSaved(long long fileSize) { markSaved(fileSize, layoutRevision); }
 
 private:
     vector<Person> group[4]; // vector容器数组 分别存放一到四组队员信息
+    long long layoutRevision = 0; // 队员增删、整体替换的次数
+    long long savedLayoutRevision = -1; // 最近一次写入文件时的layoutRevision，新建的花名册尚未保存
+    long long savedFileSize = -1; // 最近一次读取或保存时数据文件的大小
+    int nextId = 1; // 下一个可分配的队员编号，只增不减，删除队员后编号也不会被重新使用
+
+    void assignId(Person &person); // 为还没有编号的队员分配新编号；已有编号时保留，并保证之后分配的编号比它大
 };
 
@@ -1,185 +1,368 @@
 #include "Person.h"
 
+int Person::getId() const
+{
+    return d->id;
+}
+
+void Person::setId(int newId)
+{
+    if (d->id == newId) {
+        return;
+    }
+    detach();
+    d->id = newId;
+}
+
 string Person::getName() const
 {
-    return name;
+    return d->name;
 }
 
 void Person::setName(const string &newName)
 {
-    name = newName;
+    detach();
+    d->name = newName;
 }
 
 bool Person::getGender() const
 {
-    return gender;
+    return d->gender;
 }
 
 void Person::setGender(bool newGender)
 {
-    gender = newGender;
+    detach();
+    d->gender = newGender;
 }
 
 int Person::getGroup() const
 {
-    return group;
+    return d->group;
 }
 
 void Person::setGroup(int newGroup)
 {
-    group = newGroup;
+    detach();
+    d->group = newGroup;
 }
 
 bool Person::getTime(int row, int column) const
 {
     // 获取time数组某一成员的值。调用的参数采用正常思维，row行、column列，最小值为1。
-    return time[row-1][column-1];
+    if (row < 1 || row > maxTimeRows || column < 1 || column > maxDays) {
+        return false;
+    }
+    return (d->time & timeBit(row, column)) != 0;
 }
 
-void Person::setTime(bool (newTime[4][5]))
+void Person::setTime(bool (newTime[maxTimeRows][maxDays]))
 {
     // 设置time数组全部的值。用newTime替换原本的time
-    for (int i = 0; i < 4; ++i) {
-        for (int g = 0; g < 5; ++g) {
-            time[i][g] = newTime[i][g];
-        }
+    detach();
+    d->time = timeBitsOf(newTime);
+}
+void Person::setTimeBits(std::uint64_t newTime)
+{
+    if (d->time == newTime) {
+        return;
     }
+    detach();
+    d->time = newTime;
 }
 void Person::setTime(int row, int column, bool value)
 {
     // 设置time数组某一成员的值。调用的参数采用正常思维，row行、column列，最小值为1。
-    if (row >= 1 && row <= 4 && column >= 1 && column <= 5) {
-        time[row - 1][column - 1] = value;
+    // 值未变化时不复制数据，也不标记为已修改
+    if (row >= 1 && row <= maxTimeRows && column >= 1 && column <= maxDays && getTime(row, column) != value) {
+        detach();
+        d->time ^= timeBit(row, column);
     }
 
 }
 
 int Person::getTimes() const
 {
-    return times;
+    return d->times;
 }
 
 void Person::setTimes(int newTimes)
 {
-    times = newTimes;
+    if (d->times == newTimes) {
+        return;
+    }
+    detach();
+    d->times = newTimes;
 }
 
 int Person::getAll_times() const
 {
-    return all_times;
+    return d->all_times;
 }
 
 void Person::setAll_times(int newAll_times)
 {
-    all_times = newAll_times;
+    if (d->all_times == newAll_times) {
+        return;
+    }
+    detach();
+    d->all_times = newAll_times;
 }
 
 string Person::getPhone_number() const
 {
-    return phone_number;
+    return getProfile().phone_number;
 }
 
 void Person::setPhone_number(const string &newPhone_number)
 {
-    phone_number = newPhone_number;
+    PersonProfile profile = getProfile();
+    profile.phone_number = newPhone_number;
+    setProfile(profile);
 }
 
 string Person::getNative_place() const
 {
-    return native_place;
+    return getProfile().native_place;
 }
 
 void Person::setNative_place(const string &newNative_place)
 {
-    native_place = newNative_place;
+    PersonProfile profile = getProfile();
+    profile.native_place = newNative_place;
+    setProfile(profile);
 }
 
 string Person::getNative() const
 {
-    return native;
+    return getProfile().native;
 }
 
 void Person::setNative(const string &newNative)
 {
-    native = newNative;
+    PersonProfile profile = getProfile();
+    profile.native = newNative;
+    setProfile(profile);
 }
 
 string Person::getDorm() const
 {
-    return dorm;
+    return getProfile().dorm;
 }
 
 void Person::setDorm(const string &newDorm)
 {
-    dorm = newDorm;
+    PersonProfile profile = getProfile();
+    profile.dorm = newDorm;
+    setProfile(profile);
 }
 
 string Person::getSchool() const
 {
-    return school;
+    return getProfile().school;
 }
 
 void Person::setSchool(const string &newSchool)
 {
-    school = newSchool;
+    PersonProfile profile = getProfile();
+    profile.school = newSchool;
+    setProfile(profile);
 }
 
 string Person::getClassname() const
 {
-    return classname;
+    return d->classname;
 }
 
 void Person::setClassname(const string &newClassname)
 {
-    classname = newClassname;
+    detach();
+    d->classname = newClassname;
 }
 
 bool Person::getIsWork() const
 {
-    return isWork;
+    return d->isWork;
 }
 
 void Person::setIsWork(bool newIsWork)
 {
-    isWork = newIsWork;
+    // 启动时会把全部队员设为不值周，值未变化时不标记为已修改，避免无意义的保存
+    if (d->isWork == newIsWork) {
+        return;
+    }
+    detach();
+    d->isWork = newIsWork;
 }
 
 string Person::getBirthday() const
 {
-    return birthday;
+    return getProfile().birthday;
 }
 
 void Person::setBirthday(const string &newBirthday)
 {
-    birthday = newBirthday;
+    PersonProfile profile = getProfile();
+    profile.birthday = newBirthday;
+    setProfile(profile);
 }
-// 无参构造函数
-Person::Person() : name(""), gender(false), group(0), phone_number(""), native_place(""),
-    native(""), dorm(""), school(""), classname(""), birthday(""), isWork(true), times(0), all_times(0) {
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 5; ++j) {
-            time[i][j] = false;
+// 比较编号以外的全部队员信息
+bool Person::hasSameInfo(const Person &other) const
+{
+    if (d == other.d) {
+        return true; // 共用同一份数据，必然相同
+    }
+    if (!((d->name == other.d->name) && (d->group == other.d->group) && (d->gender == other.d->gender)
+          && (d->classname == other.d->classname) && (d->isWork == other.d->isWork)
+          && (d->times == other.d->times) && (d->all_times == other.d->all_times))) {
+        return false;
+    }
+    const PersonProfile &profile = getProfile();
+    const PersonProfile &otherProfile = other.getProfile();
+    return (profile.phone_number == otherProfile.phone_number) && (profile.native_place == otherProfile.native_place)
+           && (profile.native == otherProfile.native) && (profile.dorm == otherProfile.dorm)
+           && (profile.school == otherProfile.school) && (profile.birthday == otherProfile.birthday);
+}
+// 写时复制
+// 队员数据被其他Person（如撤销记录中的快照）共用时，先复制出独立的一份，保证修改只作用于当前队员
+// 全部set函数修改前都会调用，因此也在这里标记队员已修改
+void Person::detach()
+{
+    dirty = true;
+    if (d.use_count() > 1) {
+        d = std::make_shared<Data>(*d);
+    }
+}
+// 记录已写入数据文件的位置，清除修改标记
+void Person::markSaved(long long offset, int length)
+{
+    dirty = false;
+    recordOffset = offset;
+    recordLength = length;
+}
+// 接替other在数据文件中的记录位置
+void Person::takeRecordOf(const Person &other)
+{
+    dirty = true;
+    recordOffset = other.recordOffset;
+    recordLength = other.recordLength;
+}
+// 文件整体重写后记录位置改变
+void Person::moveRecord(long long offset, int length)
+{
+    recordOffset = offset;
+    recordLength = length;
+}
+// 全部档案信息
+const PersonProfile &Person::getProfile() const
+{
+    return d->profile->get();
+}
+// 查询尚未读取的档案的来源与位置，不触发读取
+const ProfileSource *Person::getUnloadedProfileSource(long long &offset) const
+{
+    const LazyProfile &lazy = *d->profile;
+    if (lazy.ready.load(std::memory_order_acquire) || !lazy.source) {
+        return nullptr;
+    }
+    offset = lazy.offset;
+    return lazy.source.get();
+}
+// 修改档案信息
+// 共享的档案可能正被其他Person使用，因此不在原档案上修改，而是替换为一份新的档案
+void Person::setProfile(const PersonProfile &newProfile)
+{
+    detach();
+    d->profile = std::make_shared<LazyProfile>(newProfile);
+}
+// 读取档案信息，第一次调用时从档案来源读出，之后直接返回
+const PersonProfile &Person::LazyProfile::get()
+{
+    std::call_once(loaded, [this]() {
+        if (!profile) {
+            profile.reset(new PersonProfile(source ? source->loadProfile(offset) : PersonProfile()));
         }
+        ready.store(true, std::memory_order_release);
+    });
+    return *profile;
+}
+// 无参构造函数
+// 读取文件、导入时先建立空队员再填入解析结果，共用一份空数据可省去一次无用的分配
+Person::Person() : d(emptyData()) {
+}
+// 移动构造与移动赋值：转移数据指针与记录位置，被移动的队员改为指向空队员数据，不会留下空指针
+Person::Person(Person &&other) noexcept
+    : d(std::move(other.d)), dirty(other.dirty), recordOffset(other.recordOffset), recordLength(other.recordLength)
+{
+    other.d = emptyData();
+}
+Person &Person::operator=(Person &&other) noexcept
+{
+    if (this != &other) {
+        d = std::move(other.d);
+        dirty = other.dirty;
+        recordOffset = other.recordOffset;
+        recordLength = other.recordLength;
+        other.d = emptyData();
     }
+    return *this;
 }
-// 全参构造
-Person::Person(const string &name, bool gender, int group, const string &phone_number, const string &native_place, const string &native, const string &dorm, const string &school, const string &classname, const string &birthday, bool isWork, bool (&time)[4][5], int times, int all_times) : name(name),
-    gender(gender),
-    group(group),
-    phone_number(phone_number),
-    native_place(native_place),
-    native(native),
-    dorm(dorm),
-    school(school),
-    classname(classname),
-    birthday(birthday),
-    isWork(isWork),
-    times(times),
-    all_times(all_times)
-{
-    for (int i = 0; i < 4; ++i) {
-        for (int g = 0; g < 5; ++g) {
-            this->time[i][g] = time[i][g];
+// 空队员共用的数据，由静态变量持有一份引用，因此任何修改都会先复制（写时复制）
+const std::shared_ptr<Person::Data> &Person::emptyData()
+{
+    static const std::shared_ptr<Data> empty = []() {
+        auto data = std::make_shared<Data>();
+        data->name = "";
+        data->gender = false;
+        data->group = 0;
+        data->profile = std::make_shared<LazyProfile>(PersonProfile());
+        data->isWork = true;
+        data->times = 0;
+        data->all_times = 0;
+        data->time = 0;
+        return data;
+    }();
+    return empty;
+}
+// time数组 -> 执勤时间表的位
+std::uint64_t Person::timeBitsOf(const bool (*time)[maxDays])
+{
+    std::uint64_t bits = 0;
+    for (int i = 0; i < maxTimeRows; ++i) {
+        for (int g = 0; g < maxDays; ++g) {
+            if (time[i][g]) {
+                bits |= timeBit(i + 1, g + 1);
+            }
         }
     }
+    return bits;
+}
+// 全参构造
+Person::Person(const string &name, bool gender, int group, const string &phone_number, const string &native_place, const string &native, const string &dorm, const string &school, const string &classname, const string &birthday, bool isWork, bool (&time)[maxTimeRows][maxDays], int times, int all_times, const std::shared_ptr<PersonArena> &arena)
+    : d(allocate<Data>(arena))
+{
+    d->name = name;
+    d->gender = gender;
+    d->group = group;
+    d->classname = classname;
+    d->profile = allocate<LazyProfile>(arena, PersonProfile{phone_number, native_place, native, dorm, school, birthday});
+    d->isWork = isWork;
+    d->times = times;
+    d->all_times = all_times;
+    d->time = timeBitsOf(time);
+}
+// 延迟读取档案信息的构造函数
+// 读取数据文件时使用：只保存排班需要的信息，档案信息第一次用到时才从文件中读出
+Person::Person(const string &name, bool gender, int group, const string &classname, bool isWork, bool (&time)[maxTimeRows][maxDays], int times, int all_times, std::shared_ptr<const ProfileSource> profileSource, long long profileOffset, const std::shared_ptr<PersonArena> &arena)
+    : d(allocate<Data>(arena))
+{
+    d->name = name;
+    d->gender = gender;
+    d->group = group;
+    d->classname = classname;
+    d->profile = allocate<LazyProfile>(arena, std::move(profileSource), profileOffset);
+    d->isWork = isWork;
+    d->times = times;
+    d->all_times = all_times;
+    d->time = timeBitsOf(time);
 }
@@ -3,57 +3,158 @@
 
 #pragma once
 #include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <new>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
 using std::string;
 
+// 队员数据内存池
+// 读取数据文件、批量导入时一次建立成千上万名队员，每名队员的数据与档案各需一次小块分配；
+// 从内存池中按16KB的大块依次切分，几百次大块分配代替数万次小块分配
+// 每个大块记录其中仍在使用的分配数，块中的数据全部释放后该块立即归还，不必等整个内存池的数据都释放：
+// 删除、修改了大部分队员后，只有仍有队员数据的大块继续占用内存
+// 分配不加锁，一个内存池只在一个线程中分配：每次读取文件、每个导入分块各用一个；释放可在任意线程进行
+class PersonArena
+{
+public:
+    explicit PersonArena(size_t blockSize = 16 * 1024) : blockSize(blockSize) {}
+    ~PersonArena() { release(current); }
+    PersonArena(const PersonArena&) = delete;
+    PersonArena& operator=(const PersonArena&) = delete;
+    void* allocate(size_t size, size_t alignment) {
+        // 每次分配前面留出一个指针大小的位置，记下所在的大块，释放时据此找到大块
+        alignment = alignment < alignof(Block*) ? alignof(Block*) : alignment;
+        size_t offset = (used + sizeof(Block*) + alignment - 1) & ~(alignment - 1);
+        if (!current || offset + size > capacity) {
+            release(current); // 内存池不再持有旧的大块，块中的数据全部释放后归还
+            offset = (sizeof(Block) + sizeof(Block*) + alignment - 1) & ~(alignment - 1);
+            capacity = offset + size > blockSize ? offset + size : blockSize;
+            // new[]得到的内存满足基本类型的对齐要求，大块首地址可直接使用
+            current = new (new unsigned char[capacity]) Block();
+        }
+        used = offset + size;
+        current->live.fetch_add(1, std::memory_order_relaxed);
+        unsigned char* address = reinterpret_cast<unsigned char*>(current) + offset;
+        *reinterpret_cast<Block**>(address - sizeof(Block*)) = current;
+        return address;
+    }
+    // 释放一次分配，所在大块中的数据全部释放、且内存池不再使用该块时归还该块
+    static void deallocate(void* address) {
+        release(*reinterpret_cast<Block**>(static_cast<unsigned char*>(address) - sizeof(Block*)));
+    }
+
+private:
+    // 大块的块头，位于大块起始处
+    struct Block {
+        std::atomic<size_t> live{1}; // 块中仍在使用的分配数，另加内存池自身持有的一个
+    };
+    size_t blockSize; // 大块的字节数
+    size_t capacity = 0; // 当前大块的字节数
+    size_t used = 0; // 当前大块已使用的字节数
+    Block* current = nullptr; // 正在切分的大块
+
+    static void release(Block* block) {
+        if (block && block->live.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            block->~Block();
+            delete[] reinterpret_cast<unsigned char*>(block);
+        }
+    }
+};
+
+// 从PersonArena分配的分配器，供std::allocate_shared使用
+// 每份共享数据的控制块中保存一个分配器，持有内存池的引用；数据释放时归还到所在的大块
+template <class T>
+struct ArenaAllocator
+{
+    using value_type = T;
+    std::shared_ptr<PersonArena> arena;
+
+    explicit ArenaAllocator(std::shared_ptr<PersonArena> arena) : arena(std::move(arena)) {}
+    template <class U>
+    ArenaAllocator(const ArenaAllocator<U>& other) : arena(other.arena) {}
+    T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n * sizeof(T), alignof(T))); }
+    void deallocate(T* p, size_t) { PersonArena::deallocate(p); }
+    template <class U>
+    bool operator==(const ArenaAllocator<U>& other) const { return arena == other.arena; }
+    template <class U>
+    bool operator!=(const ArenaAllocator<U>& other) const { return arena != other.arena; }
+};
+
+// 队员档案信息
+// 电话、籍贯、民族、寝室、学院、生日只在展示、修改队员信息和保存文件时才会用到，排班用不到
+struct PersonProfile
+{
+    string phone_number; // 电话号码
+    string native_place; // 籍贯
+    string native; // 民族
+    string dorm; // 寝室号
+    string school; // 学院
+    string birthday; // 生日信息
+};
+
+// 档案来源
+// 读取数据文件时只记录每名队员档案所在的位置，第一次用到档案信息时再通过档案来源按位置读出
+class ProfileSource
+{
+public:
+    virtual ~ProfileSource() = default;
+    virtual PersonProfile loadProfile(long long offset) const = 0; // 读取位于offset处的档案信息
+};
+
 
 class Person
 {
 public:
+    // 执勤时间表的容量：行为仪式与地点的组合，列为星期（从周一起），实际的行数、列数由执勤地点与仪式登记表决定
+    static constexpr int maxTimeRows = 8;
+    static constexpr int maxDays = 7;
+
     // 构造函数
+    // 无参构造不分配内存，全部空队员共用同一份空数据，第一次修改时才复制（写时复制）
+    // arena：给出时队员数据从内存池中分配，批量建立队员时使用
     Person();
     Person(const string &name, bool gender, int group,
            const string &phone_number, const string &native_place,
            const string &native, const string &dorm, const string &school,
-           const string &classname, const string &birthday, bool isWork, bool (&time)[4][5],
-           int times, int all_times);
-    // 重载赋值运算符
-    // 对成员变量全部赋新值
-    Person& operator=(const Person& other) {
-        if (this != &other) {
-            name = other.name; // 队员姓名
-            gender = other.gender; // 性别（0：男，1：女）
-            group = other.group; // 所属组别
-            phone_number = other.phone_number; // 电话号码
-            native_place = other.native_place; // 籍贯
-            native = other.native; // 民族
-            dorm = other.dorm; // 寝室号
-            school = other.school; // 学院
-            classname = other.classname; // 专业班级
-            birthday = other.birthday; // 生日信息
-            isWork = other.isWork; // 是否参加执勤标记，用于勾选整组执勤时调用
-            for (int i = 0; i < 4; ++i) {
-                for (int j = 0; j < 5; ++j) {
-                    time[i][j] = other.time[i][j]; // 队员执勤时间安排，对应20个任务时间点是否有时间。一周升降旗十次任务，一次任务两个校区：10*2=20。
-                }
-            }
-            times = other.times; // 一次排班执勤次数，用于记录一周执勤该队员的执勤次数
-            all_times = other.all_times; // 学期总执勤次数，用于采用总次数排班规则时使用
-        }
-        return *this;
-    }
-    // 重载 == 运算符，通过姓名和所属组别判定是否为同一人
+           const string &classname, const string &birthday, bool isWork, bool (&time)[maxTimeRows][maxDays],
+           int times, int all_times, const std::shared_ptr<PersonArena> &arena = nullptr);
+    // 延迟读取档案信息的构造函数，只保存排班需要的信息，档案信息在第一次用到时从profileSource的offset处读出
+    Person(const string &name, bool gender, int group, const string &classname, bool isWork, bool (&time)[maxTimeRows][maxDays],
+           int times, int all_times, std::shared_ptr<const ProfileSource> profileSource, long long profileOffset,
+           const std::shared_ptr<PersonArena> &arena = nullptr);
+    // 复制与赋值
+    // 复制Person只复制指向队员数据的指针，不复制十个字符串（写时复制）：
+    // 撤销记录保存的花名册快照与界面中的队员共用同一份数据，只有在其中一方被修改时才真正复制该队员
+    Person(const Person& other) = default;
+    Person& operator=(const Person& other) = default;
+    // 移动只转移指针，批量加入队员时使用；移动后的队员指向空队员数据，仍可正常读取与赋值
+    Person(Person&& other) noexcept;
+    Person& operator=(Person&& other) noexcept;
+    // 重载 == 运算符，判定是否为同一名队员
+    // 两人都有队员编号时只比较编号，一次整数比较；改名、改专业班级后仍是同一人
+    // 尚未加入花名册、还没有编号的队员（如新建、导入的队员）按姓名+性别+专业班级判定
     bool operator==(const Person& other) const {
-        return (name == other.name) && (group == other.group) && (gender == other.gender) && (phone_number == other.phone_number)
-               && (native_place == other.native_place)&& (native == other.native)&& (dorm == other.dorm)
-            && (school == other.school)&& (classname == other.classname)&& (birthday == other.birthday)&& (isWork == other.isWork)
-            && (times == other.times)&& (all_times == other.all_times);
+        if (d->id != 0 && other.d->id != 0) {
+            return d->id == other.d->id;
+        }
+        return (d->name == other.d->name) && (d->gender == other.d->gender) && (d->classname == other.d->classname);
     }
     // 重载 != 运算符, ==运算符取反
     bool operator!=(const Person& other) const {
         return !(*this == other);
     }
+    // 比较编号以外的全部队员信息，判断队员信息是否被修改过
+    // 先比较常驻内存的信息，全部相同时才读取并比较档案信息
+    bool hasSameInfo(const Person& other) const;
 
     // get/set函数声明
+    // 队员编号，加入花名册时由Flag_group分配，保存在数据文件中，改名后不变；0表示尚未分配
+    int getId() const;
+    void setId(int newId);
     // 姓名
     string getName() const;
     void setName(const string &newName);
@@ -64,9 +165,12 @@ public:
     int getGroup() const;
     void setGroup(int newGroup);
     // 可执勤时间数组
-    bool getTime(int row, int column) const;
-    void setTime(bool newtime[4][5]);// 设置time数组全部的值。
+    bool getTime(int row, int column) const; // 超出执勤时间表容量的行列视为没空
+    void setTime(bool newtime[maxTimeRows][maxDays]);// 设置time数组全部的值。
     void setTime(int row, int column, bool value);// 设置time数组某一成员的值。调用的参数采用正常思维，row行、column列，最小值为1。
+    // 整张执勤时间表，第row行第column列对应第(row - 1) * maxDays + (column - 1)位，用于保存到文件、比较与计算缓存键
+    std::uint64_t getTimeBits() const { return d->time; }
+    void setTimeBits(std::uint64_t newTime);
     // 一周执勤次数
     int getTimes() const;
     void setTimes(int newTimes);
@@ -97,23 +201,65 @@ public:
     // 生日信息
     string getBirthday() const;
     void setBirthday(const string &newBirthday);
+    // 全部档案信息，尚未读取时先从档案来源读出
+    const PersonProfile& getProfile() const;
+    // 档案信息尚未读取时返回档案来源，并通过offset给出档案在来源中的位置；已读取或不是延迟读取的返回nullptr
+    // 整体保存文件时据此直接复制原记录中的档案字段，不必为保存读出档案
+    const ProfileSource* getUnloadedProfileSource(long long &offset) const;
+
+    // 保存状态：读取或保存后是否被修改过（全部set函数都会标记），以及该队员记录在数据文件中的位置
+    // 保存时只需改写修改过的队员记录，长度不变时可以直接覆盖原位置
+    bool isDirty() const { return dirty; }
+    long long getRecordOffset() const { return recordOffset; } // 记录的起始位置，不在文件中时为-1
+    int getRecordLength() const { return recordLength; } // 记录的字节数，不含换行
+    void markSaved(long long offset, int length); // 记录已写入文件的位置，清除修改标记
+    void takeRecordOf(const Person& other); // 接替other在文件中的记录位置（整体替换队员信息时使用），并标记为已修改
+    void moveRecord(long long offset, int length); // 文件整体重写后记录位置改变，保留修改标记
+    bool sharesDataWith(const Person& other) const { return d == other.d; } // 是否仍与other共用同一份数据，即复制后双方都未修改过
 
 private:
-    // 类成员变量
-    // 队员基本信息
-    string name; // 队员姓名
-    bool gender; // 性别（0：男，1：女）
-    int group; // 所属组别
-    string phone_number; // 电话号码
-    string native_place; // 籍贯
-    string native; // 民族
-    string dorm; // 寝室号
-    string school; // 学院
-    string classname; // 专业班级
-    string birthday; // 生日信息
-    // 队员执勤所需信息
-    bool isWork; // 是否参加执勤标记，用于勾选整组执勤时调用
-    bool time[4][5]; // 队员执勤时间安排，对应20个任务时间点是否有时间。一周升降旗十次任务，一次任务两个校区：10*2=20。
-    int times; // 一次排班执勤次数，用于记录一周执勤该队员的执勤次数
-    int all_times; // 学期总执勤次数，用于采用总次数排班规则时使用
+    // 延迟读取的档案信息，由共用同一份队员数据的Person共享，只会读取一次（多线程同时访问也安全）
+    struct LazyProfile {
+        explicit LazyProfile(const PersonProfile& profile) : profile(new PersonProfile(profile)), ready(true) {}
+        LazyProfile(std::shared_ptr<const ProfileSource> source, long long offset) : source(std::move(source)), offset(offset) {}
+        const PersonProfile& get();
+        std::once_flag loaded; // 保证档案只读取一次
+        std::unique_ptr<PersonProfile> profile; // 档案信息，读取前为空，不占用字符串内存
+        std::atomic<bool> ready{false}; // 档案是否已读出，其他线程不经call_once查询时使用
+        const std::shared_ptr<const ProfileSource> source; // 档案来源，读取后也不释放，保存时可在其他线程中安全查询
+        const long long offset = 0; // 档案在来源中的位置
+    };
+    // 队员数据，由多个Person共用，修改前通过detach()确保只修改自己的那一份
+    struct Data {
+        int id = 0; // 队员编号
+        // 队员基本信息
+        string name; // 队员姓名
+        bool gender; // 性别（0：男，1：女）
+        int group; // 所属组别
+        string classname; // 专业班级
+        std::shared_ptr<LazyProfile> profile; // 电话、籍贯、民族、寝室、学院、生日
+        // 队员执勤所需信息
+        bool isWork; // 是否参加执勤标记，用于勾选整组执勤时调用
+        std::uint64_t time; // 队员执勤时间安排，每一位对应一个任务时间点是否有时间（见getTimeBits）。默认一周升降旗十次任务，一次任务两个校区：10*2=20
+        int times; // 一次排班执勤次数，用于记录一周执勤该队员的执勤次数
+        int all_times; // 学期总执勤次数，用于采用总次数排班规则时使用
+    };
+    std::shared_ptr<Data> d; // 指向队员数据的共享指针
+    bool dirty = true; // 读取或保存后是否被修改过，新建的队员尚未保存
+    long long recordOffset = -1; // 队员记录在数据文件中的起始位置
+    int recordLength = 0; // 队员记录的字节数
+
+    // 从内存池（未给出时从堆）分配共享数据
+    template <class T, class... Args>
+    static std::shared_ptr<T> allocate(const std::shared_ptr<PersonArena>& arena, Args&&... args) {
+        if (arena) {
+            return std::allocate_shared<T>(ArenaAllocator<T>(arena), std::forward<Args>(args)...);
+        }
+        return std::make_shared<T>(std::forward<Args>(args)...);
+    }
+    static const std::shared_ptr<Data>& emptyData(); // 空队员共用的数据
+    void detach(); // 写时复制：数据被其他Person共用时，先复制出独立的一份再修改；同时标记为已修改
+    void setProfile(const PersonProfile& newProfile); // 修改档案信息：复制出独立的队员数据后替换档案
+    static std::uint64_t timeBit(int row, int column) { return std::uint64_t(1) << ((row - 1) * maxDays + (column - 1)); }
+    static std::uint64_t timeBitsOf(const bool (*time)[maxDays]); // time数组（maxTimeRows行） -> 执勤时间表的位
 };
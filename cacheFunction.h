@@ -0,0 +1,74 @@
+// cacheFunction.h头文件
+// 功能说明：排班结果缓存ScheduleCache
+// 排班结果只取决于参加排班队员的排班相关信息（队员编号、执勤时间、总次数规则下的总执勤次数）、排班规则、
+// 随机数种子以及执勤地点与仪式登记表
+// SchedulingManager把这些内容按固定顺序拼接后取SHA-256摘要作为缓存键，键相同时直接复用上次的结果，无需重新排班
+// 花名册、规则或登记表任何影响排班的修改都会得到不同的摘要，摘要碰撞的概率可以忽略，旧结果不会被误用
+// 窗口、多单位并行排班与花名册服务共用同一个缓存，可在多个线程中同时使用
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <list>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+// ScheduleCache 类定义，排班结果缓存，只保留最近使用的若干条结果
+class ScheduleCache
+{
+public:
+    // 一条排班结果
+    struct Entry {
+        std::vector<int> seats; // 每个岗位的队员，值为参加排班队员列表（打乱顺序前）中的下标，-1为空岗
+        QStringList warnings; // 排班过程中发出的警告，复用结果时按原顺序重新发出
+    };
+
+    // 全程序共用的缓存
+    static ScheduleCache& instance() {
+        static ScheduleCache cache;
+        return cache;
+    }
+
+    // 查找结果，命中时写入entry并将其标记为最近使用
+    bool find(const std::string& key, Entry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it == index.end()) {
+            return false;
+        }
+        entries.splice(entries.begin(), entries, it->second); // 移到最前
+        entry = it->second->second;
+        return true;
+    }
+    // 保存结果，超出容量时丢弃最久未使用的结果
+    void insert(const std::string& key, const Entry& entry) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = index.find(key);
+        if (it != index.end()) {
+            it->second->second = entry;
+            entries.splice(entries.begin(), entries, it->second);
+            return;
+        }
+        entries.emplace_front(key, entry);
+        index[key] = entries.begin();
+        if (entries.size() > capacity) {
+            index.erase(entries.back().first);
+            entries.pop_back();
+        }
+    }
+    // 清空缓存
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.clear();
+        index.clear();
+    }
+
+private:
+    static constexpr size_t capacity = 16; // 最多保留的结果数
+    std::mutex mutex; // 保护以下成员
+    std::list<std::pair<std::string, Entry>> entries; // 按最近使用排列的结果，最前为最近使用
+    std::unordered_map<std::string, std::list<std::pair<std::string, Entry>>::iterator> index; // 缓存键 -> 结果
+};
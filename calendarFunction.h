@@ -0,0 +1,183 @@
+// calendarFunction.h头文件
+// 功能说明：执勤日历导出DutyCalendarExporter，把排班结果导出为iCalendar（.ics）文件，队员可以直接导入手机日历
+// 可以导出一次排班的工作表格，也可以导出执勤历史中一段日期（如一学期）内的全部排班
+// 每名队员一个.ics文件，另有一个合并的日历（每次执勤任务一个日程，列出三名执勤队员）
+// 日程的日期由该周周一与时间段对应的星期算出，开始时间与时长取自执勤地点与仪式登记表
+//
+// 全部岗位只遍历一遍：每个执勤任务（时间段+地点）的日程内容只生成一次，追加到三名队员各自的缓冲区和合并日历中，
+// 遍历结束后每个文件整块写出一次
+
+#pragma once
+
+#include <QDate>
+#include <QDateTime>
+#include <QDir>
+#include <QSaveFile>
+#include <QByteArray>
+#include <QStringList>
+#include <array>
+#include <vector>
+#include <unordered_map>
+#include "dataFunction.h"
+#include "fileFunction.h"
+#include "historyFunction.h"
+#include "siteFunction.h"
+
+// DutyCalendarExporter 类定义，执勤日历导出
+class DutyCalendarExporter
+{
+public:
+    // 构造函数
+    // 参数：SiteRegistry：执勤地点与仪式登记表，提供地点名称、仪式名称与时间
+    explicit DutyCalendarExporter(const SiteRegistry& registry)
+        : registry(registry), stamp(QDateTime::currentDateTimeUtc().toString("yyyyMMdd'T'HHmmss").toUtf8() + "Z") {}
+
+    // 加入一次排班的工作表格。参数：monday：该表格对应那一周的周一
+    void addTable(const ScheduleTable& table, const QDate& monday) {
+        for (int slot = 0; slot < table.slotCount(); ++slot) {
+            for (int location = 0; location < table.siteCount(); ++location) {
+                std::array<Attendee, ScheduleTable::peoplePerLocation> crew;
+                int people = 0;
+                for (Person* person : table.crew(slot, location)) {
+                    if (person) {
+                        crew[people++] = {person->getId(), QString::fromStdString(person->getName())};
+                    }
+                }
+                addCrew(monday, slot, location, crew.data(), people);
+            }
+        }
+    }
+    // 加入执勤历史中[from, to]日期范围内的全部排班
+    void addHistory(const ScheduleHistory& history, const QDate& from, const QDate& to) {
+        history.forEachWeek(from, to, [&](const QDate& monday, const std::vector<int>& seats) {
+            for (int slot = 0; slot < registry.slotCount(); ++slot) {
+                QDate date = monday.addDays(registry.slotDay(slot) - 1);
+                if (date < from || date > to) {
+                    continue;
+                }
+                for (int location = 0; location < registry.siteCount(); ++location) {
+                    std::array<Attendee, ScheduleTable::peoplePerLocation> crew;
+                    int people = 0;
+                    for (int position = 0; position < ScheduleTable::peoplePerLocation; ++position) {
+                        int index = seats[(slot * registry.siteCount() + location) * ScheduleTable::peoplePerLocation + position];
+                        if (index >= 0) {
+                            const ScheduleHistory::Member& member = history.member(index);
+                            // 旧版历史中没有队员编号的队员，以历史编号区分（取负数，不与队员编号冲突）
+                            crew[people++] = {member.id > 0 ? member.id : -(index + 1), QString::fromStdString(member.name)};
+                        }
+                    }
+                    addCrew(monday, slot, location, crew.data(), people);
+                }
+            }
+        });
+    }
+
+    // 每名队员写出一个.ics文件到directory，文件名为“姓名_队员编号.ics”（姓名中不能用于文件名的字符替换为“_”），
+    // 旧版历史中没有队员编号的队员为“姓名_h历史编号.ics”，同名的旧版队员不会写入同一个文件
+    // 返回写出的文件数，目录无法创建时返回-1
+    int writePerMember(const QString& directory) const {
+        QDir dir;
+        if (!dir.exists(directory) && !dir.mkpath(directory)) {
+            return -1;
+        }
+        int written = 0;
+        for (int key : order) {
+            const MemberCalendar& calendar = calendars.at(key);
+            QString suffix = key > 0 ? QString::number(key) : "h" + QString::number(-key); // key为负数时是历史编号+1取负
+            QString filename = QDir(directory).filePath(FlagGroupFileManager::safeFileName(calendar.name) + "_" + suffix + ".ics");
+            if (writeCalendar(filename, calendar.name + " 的执勤安排", calendar.events)) {
+                ++written;
+            }
+        }
+        return written;
+    }
+    // 写出合并的日历，每次执勤任务一个日程
+    bool writeCombined(const QString& filename) const {
+        return writeCalendar(filename, "国旗班执勤安排", combined);
+    }
+    int memberCount() const { return static_cast<int>(order.size()); } // 有执勤安排的队员数
+
+private:
+    // 日程中的一名执勤队员
+    struct Attendee {
+        int key = 0; // 队员编号，旧版历史中没有编号的队员为负数（见addHistory）
+        QString name; // 姓名
+    };
+    // 一名队员的日历
+    struct MemberCalendar {
+        QString name; // 姓名
+        QByteArray events; // 全部日程，已按iCalendar格式编码
+    };
+
+    const SiteRegistry& registry; // 执勤地点与仪式登记表
+    QByteArray stamp; // 导出时间，每个日程的DTSTAMP
+    std::unordered_map<int, MemberCalendar> calendars; // 队员编号 -> 日历
+    std::vector<int> order; // 队员首次出现的顺序，写出文件时按此顺序
+    QByteArray combined; // 合并日历的全部日程
+
+    // 一次执勤任务：生成一次日程内容，加入各执勤队员的日历与合并日历
+    void addCrew(const QDate& monday, int slot, int location, const Attendee* crew, int people) {
+        if (people == 0) {
+            return;
+        }
+        const SiteRegistry::Ceremony& ceremony = registry.ceremony(registry.slotHalfDay(slot));
+        QDateTime start(monday.addDays(registry.slotDay(slot) - 1), ceremony.start);
+        QByteArray uid = start.toString("yyyyMMdd'T'HHmm").toUtf8() + "-" + registry.site(location).code.toUtf8();
+        QStringList names;
+        for (int i = 0; i < people; ++i) {
+            names << crew[i].name;
+        }
+        // 各日历共用的日程内容（不含UID）
+        QByteArray body;
+        body += "DTSTAMP:" + stamp + "\r\n";
+        body += "DTSTART:" + start.toString("yyyyMMdd'T'HHmmss").toUtf8() + "\r\n";
+        body += "DTEND:" + start.addSecs(ceremony.minutes * 60).toString("yyyyMMdd'T'HHmmss").toUtf8() + "\r\n";
+        body += contentLine("SUMMARY", registry.site(location).name + ceremony.name + "执勤");
+        body += contentLine("LOCATION", registry.site(location).name);
+        body += contentLine("DESCRIPTION", "执勤队员：" + names.join("、"));
+        body += "END:VEVENT\r\n";
+        combined += "BEGIN:VEVENT\r\nUID:" + uid + "@flag-group\r\n" + body;
+        for (int i = 0; i < people; ++i) {
+            auto it = calendars.find(crew[i].key);
+            if (it == calendars.end()) {
+                it = calendars.emplace(crew[i].key, MemberCalendar{crew[i].name, QByteArray()}).first;
+                order.push_back(crew[i].key);
+            }
+            it->second.events += "BEGIN:VEVENT\r\nUID:" + uid + "-" + QByteArray::number(crew[i].key) + "@flag-group\r\n" + body;
+        }
+    }
+    // 一行“名称:值”，值中的特殊字符按iCalendar规则转义，超过75字节时折行（不拆开UTF-8字符）
+    static QByteArray contentLine(const char* name, const QString& value) {
+        QString escaped = value;
+        escaped.replace("\\", "\\\\").replace(";", "\\;").replace(",", "\\,").replace("\n", "\\n");
+        QByteArray line = QByteArray(name) + ":" + escaped.toUtf8();
+        QByteArray folded;
+        int start = 0;
+        int limit = 75;
+        while (line.size() - start > limit) {
+            int end = start + limit;
+            while ((static_cast<uchar>(line[end]) & 0xC0) == 0x80) {
+                --end; // 退到UTF-8字符的第一个字节
+            }
+            folded += line.mid(start, end - start) + "\r\n ";
+            start = end;
+            limit = 74; // 续行以一个空格开头
+        }
+        folded += line.mid(start) + "\r\n";
+        return folded;
+    }
+    // 写出一个日历文件
+    static bool writeCalendar(const QString& filename, const QString& title, const QByteArray& events) {
+        QSaveFile file(filename);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return false;
+        }
+        QByteArray content;
+        content.reserve(events.size() + 256);
+        content += "BEGIN:VCALENDAR\r\nVERSION:2.0\r\nPRODID:-//WHUT Flag Group//Duty Schedule//ZH\r\nCALSCALE:GREGORIAN\r\n";
+        content += contentLine("X-WR-CALNAME", title);
+        content += events;
+        content += "END:VCALENDAR\r\n";
+        return file.write(content) == content.size() && file.commit();
+    }
+};
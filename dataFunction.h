@@ -17,14 +17,71 @@
 
 #include <QObject>
 #include <QDebug>
+#include <QCryptographicHash>
+#include <QStringList>
+#include <array>
 #include <vector>
 #include <algorithm>
 #include <random>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include "Person.h"
 #include "Flag_group.h"
+#include "siteFunction.h"
+#include "cacheFunction.h"
 
 
+// 岗位视图，指向工作表格中若干个连续岗位，只读、不复制
+struct SeatView
+{
+    Person* const* first; // 第一个岗位
+    int count; // 岗位数
+    Person* const* begin() const { return first; }
+    Person* const* end() const { return first + count; }
+    int size() const { return count; }
+    Person* operator[](int i) const { return first[i]; }
+};
+
+// ScheduleTable 类定义，工作表格
+// 时间段数 * 地点数 * 3个岗位，默认10 * 2 * 3 = 60个岗位，按时间段、地点、岗位的顺序连续存放在定长数组中，每个岗位只保存队员指针
+// 时间段数与地点数由执勤地点与仪式登记表决定，数组按登记表允许的最大岗位数分配，不随登记表变化重新分配
+// 同一时间段的全部岗位、同一任务的3个岗位在内存中相邻，可以直接返回SeatView供界面、导出和分析代码读取
+class ScheduleTable
+{
+public:
+    static constexpr int peoplePerLocation = 3; // 一个工作地点的三名执勤队员
+    static constexpr int maxSeats = SiteRegistry::maxCrews * peoplePerLocation; // 岗位数的上限
+
+    // 参数：registry：执勤地点与仪式登记表，决定时间段数与地点数
+    explicit ScheduleTable(const SiteRegistry& registry = SiteRegistry::defaults())
+        : timeSlots(registry.slotCount()), locations(registry.siteCount()) { clear(); }
+
+    int slotCount() const { return timeSlots; } // 一周的时间段数，默认10个
+    int siteCount() const { return locations; } // 每个时间段的地点数，默认2个（0:南鉴湖、1:东西院）
+    int seatCount() const { return timeSlots * locations * peoplePerLocation; } // 岗位总数
+    // 岗位编号
+    int index(int slot, int location, int position) const {
+        return (slot * locations + location) * peoplePerLocation + position;
+    }
+    // 读取/设置某一岗位的队员，nullptr表示空岗
+    Person* at(int slot, int location, int position) const { return seats[index(slot, location, position)]; }
+    void set(int slot, int location, int position, Person* person) { seats[index(slot, location, position)] = person; }
+    // 清空全部岗位
+    void clear() { seats.fill(nullptr); }
+    // 某时间段某地点的3个岗位
+    SeatView crew(int slot, int location) const { return { &seats[index(slot, location, 0)], peoplePerLocation }; }
+    // 某时间段全部地点的岗位，默认6个
+    SeatView slotSeats(int slot) const { return { &seats[index(slot, 0, 0)], locations * peoplePerLocation }; }
+    // 全部岗位，默认60个
+    SeatView allSeats() const { return { seats.data(), seatCount() }; }
+
+private:
+    int timeSlots; // 时间段数
+    int locations; // 地点数
+    std::array<Person*, maxSeats> seats; // 岗位数组
+};
+
 // SchedulingManager 类定义，执勤工作表
 class SchedulingManager : public QObject
 {
@@ -42,19 +99,39 @@ public:
         AllHandoverRule // 全周（周二至周五）南鉴湖升旗采用交接规则
     };
     // 构造函数
-    SchedulingManager(const Flag_group& flagGroup, bool useTotalTimesRule = false, HandoverRule handoverRule = NoRule)
-        : flagGroup(flagGroup), useTotalTimesRule(useTotalTimesRule), handoverRule(handoverRule) {
+    // 参数：Flag_group：要排班的花名册，构造时复制一份快照（写时复制，只复制队员指针），排班只读写快照，
+    // 可以在后台线程中排班，同时在界面线程中继续修改花名册；排班结果由commitDutyCounts写回
+    // SiteRegistry：执勤地点与仪式登记表，提供时间段、地点到执勤时间表行列的对照以及警告信息中的名称
+    SchedulingManager(const Flag_group& flagGroup, bool useTotalTimesRule = false, HandoverRule handoverRule = NoRule,
+                      const SiteRegistry& registry = SiteRegistry::defaults())
+        : baseline(flagGroup), flagGroup(std::make_shared<Flag_group>(flagGroup)), useTotalTimesRule(useTotalTimesRule),
+          handoverRule(handoverRule), registry(registry), scheduleTable(registry) {
         initializeAvailableMembers();// 通过队员的isWork的信息统计参加排班的人
     }
     // 部署工作表基础准备资源，排班操作的入口
     void schedule() {
-        const int totalSlots = 10;// 一周10个工作时间段,升旗时间对应0 2 4 6 8
-        const int locationsPerSlot = 2;// 两个工作地点（0:南鉴湖、1:东西院）
-        const int peoplePerLocation = 3;// 一个工作地点的三名执勤队员
+        const int totalSlots = scheduleTable.slotCount();// 一周的工作时间段数，默认10个，升旗时间对应0 2 4 6 8
+        const int locationsPerSlot = scheduleTable.siteCount();// 工作地点数，默认两个（0:南鉴湖、1:东西院）
+        const int peoplePerLocation = ScheduleTable::peoplePerLocation;// 一个工作地点的三名执勤队员
         for (auto& member : availableMembers) {
             // 重置每个参加排班的队员本周的工作次数：0
             member->setTimes(0);
         }
+        emittedWarnings.clear();
+
+        // 指定了随机数种子时，相同的花名册、规则与种子必然得到相同的结果，先查找排班结果缓存
+        std::string cacheKey;
+        if (hasSeed && cacheEnabled) {
+            cacheKey = fingerprint();
+            ScheduleCache::Entry cached;
+            if (ScheduleCache::instance().find(cacheKey, cached)) {
+                applyCachedResult(cached);
+                emit schedulingFinished();
+                return;
+            }
+        }
+        // 打乱顺序前的参加排班队员列表，缓存结果以其中的下标保存队员
+        const std::vector<Person*> memberOrder = availableMembers;
 
         // 随机数生成装置，生成高质量随机数种子，理论上不可能重复
         std::random_device rd;
@@ -62,7 +139,8 @@ public:
         // std::mt19937 是一个基于梅森旋转算法的伪随机数生成器，能够生成高质量的随机数序列。
         // 理论上存在重复的可能，但运算周期极长，只要随机数种子不同，理论不会重复。
         // 因为是伪随机数，所以种子一样，结果一样
-        std::mt19937 g(rd());
+        // 指定了种子时使用指定的种子，排班结果可以复现
+        std::mt19937 g(hasSeed ? static_cast<std::mt19937::result_type>(seed) : rd());
         // 调用 std::shuffle 函数，将 availableMembers 向量中的元素顺序随机打乱。
         // std::shuffle 函数接受三个参数：容器的起始迭代器、容器的结束迭代器以及随机数引擎。
         // 借助 std::shuffle 函数，能够将 availableMembers 向量中的队员指针顺序随机打乱。
@@ -73,62 +151,166 @@ public:
 
 
         // 排班！
-        // 对 scheduleTable 进行初始化，它是一个三维向量，用于存储排班结果。
-        // totalSlots：表示一周内的总工作时间段数量。在当前的排班规则下，一周工作 5 天，每天分上午和下午两个时间段，所以 totalSlots 为 10。
-        // locationsPerSlot：每个工作时间段内的工作地点数量，这里是 2 个（“NJH” 和 “DXY”）。
+        // 对 scheduleTable 进行初始化，它是一个定长的岗位数组，用于存储排班结果。
+        // totalSlots：表示一周内的总工作时间段数量。默认一周工作 5 天，每天分上午和下午两个时间段，所以 totalSlots 为 10。
+        // locationsPerSlot：每个工作时间段内的工作地点数量，默认是 2 个（“NJH” 和 “DXY”）。
         // peoplePerLocation：每个工作地点需要的工作人员数量，这里是 3 人。
         // nullptr：初始时，每个排班位置都设置为 nullptr，表示尚未安排人员。
-        scheduleTable.resize(totalSlots, std::vector<std::vector<Person*>>(locationsPerSlot, std::vector<Person*>(peoplePerLocation, nullptr)));
+        scheduleTable.clear();
         for (int slot = 0; slot < totalSlots; ++slot) {
             //外层循环遍历工作时间段
-            int day = slot / 2 + 1;//值为1~5。表示星期
-            int halfDay = slot % 2;//值为0~1。0:上午，1：下午
+            int day = registry.slotDay(slot);//默认值为1~5。表示星期
             for (int location = 0; location < locationsPerSlot; ++location) {
                 // 中层循环遍历工作地点
-                int timeRow = halfDay * 2 + location + 1;//location=0~1,timeRow=1~4，分别表示NJH升旗，DXY升旗，NJH降旗，DXY降旗
+                int timeRow = registry.timeRow(slot, location);//默认location=0~1,timeRow=1~4，分别表示NJH升旗，DXY升旗，NJH降旗，DXY降旗
                 for (int position = 0; position < peoplePerLocation; ++position) {
                     //内层循环遍历工作岗位
                     Person* selectedPerson = selectPerson(slot, timeRow, location, day);//选择合适队员
                     if (selectedPerson) {
                         // 如果找到合适队员，加入工作表格scheduleTable中
-                        scheduleTable[slot][location][position] = selectedPerson;
+                        scheduleTable.set(slot, location, position, selectedPerson);
                         selectedPerson->setTimes(selectedPerson->getTimes() + 1);
                         selectedPerson->setAll_times(selectedPerson->getAll_times() + 1);
                     }
                 }
             }
         }
+#ifndef QT_NO_DEBUG
+        // 调试版本在每次排班后检查排班结果是否满足全部排班规则，便于修改排班逻辑后及时发现问题
+        const QStringList violations = checkInvariants();
+        Q_ASSERT_X(violations.isEmpty(), "SchedulingManager::schedule", qPrintable(violations.join("\n")));
+#endif
+        if (hasSeed && cacheEnabled) {
+            // 保存到排班结果缓存
+            ScheduleCache::Entry entry;
+            std::unordered_map<const Person*, int> positions;
+            for (size_t i = 0; i < memberOrder.size(); ++i) {
+                positions[memberOrder[i]] = static_cast<int>(i);
+            }
+            for (Person* person : scheduleTable.allSeats()) {
+                entry.seats.push_back(person ? positions[person] : -1);
+            }
+            entry.warnings = emittedWarnings;
+            ScheduleCache::instance().insert(cacheKey, entry);
+        }
         // 发出排班完成信号
         emit schedulingFinished();
     }
 
+    // 把本次排班得到的执勤次数写回花名册live，在live所在线程（界面线程）调用，返回写回的队员数
+    // 排班期间live可能被修改：没有增删过队员时按位置对应，否则按队员编号查找（Flag_group::findPersonInGroup），已被删除的队员跳过
+    // 本周次数直接写入；总次数只加上本次排班的增量，排班期间对总次数的修改（如归零）得以保留
+    int commitDutyCounts(Flag_group& live) const {
+        bool sameLayout = live.getLayoutRevision() == baseline.getLayoutRevision();
+        int committed = 0;
+        for (int group = 1; group <= 4; ++group) {
+            const auto& before = baseline.getGroupMembers(group);
+            const auto& after = flagGroup->getGroupMembers(group);
+            auto& members = live.getGroupMembers(group);
+            for (size_t row = 0; row < after.size(); ++row) {
+                if (!after[row].getIsWork()) {
+                    continue; // 未参加排班，执勤次数没有变化
+                }
+                Person* target = sameLayout ? &members[row] : live.findPersonInGroup(after[row], group);
+                if (!target) {
+                    continue;
+                }
+                target->setTimes(after[row].getTimes());
+                target->setAll_times(target->getAll_times() + after[row].getAll_times() - before[row].getAll_times());
+                ++committed;
+            }
+        }
+        return committed;
+    }
+
+    // 指定随机数种子，未指定时每次排班使用不同的随机种子，结果不会被缓存
+    void setSeed(quint64 newSeed) {
+        seed = newSeed;
+        hasSeed = true;
+    }
+
+    // 是否使用排班结果缓存，默认使用。结果只用一次的批量排班（如假设分析的各场景）关闭，避免挤掉常用的结果
+    void setCacheEnabled(bool enabled) { cacheEnabled = enabled; }
+
+    // 排班结果检查函数，返回违反排班规则的说明，全部满足时返回空列表
+    QStringList checkInvariants() const;
+
     // 成员变量的get与set函数声明
     bool getUseTotalTimesRule() const;
     void setUseTotalTimesRule(bool newUseTotalTimesRule);
     const Flag_group &getFlagGroup() const;
-    std::vector<Person *> getAvailableMembers() const;
+    std::shared_ptr<Flag_group> getScheduledRoster() const { return flagGroup; } // 排班后的花名册快照，工作表格中的队员指针指向其中的队员
+    const std::vector<Person *> &getAvailableMembers() const;
     void setAvailableMembers(const std::vector<Person *> &newAvailableMembers);
-    std::vector<std::vector<std::vector<Person *> > > getScheduleTable() const;
-    void setScheduleTable(const std::vector<std::vector<std::vector<Person *> > > &newScheduleTable);
+    const ScheduleTable &getScheduleTable() const;
+    void setScheduleTable(const ScheduleTable &newScheduleTable);
     HandoverRule getHandoverRule() const;
     void setHandoverRule(HandoverRule newHandoverRule);
 
 private:
-    const Flag_group& flagGroup; // 国旗班容器，保存队员信息
+    const Flag_group baseline; // 排班开始时的花名册快照，写回时用于计算总次数的增量
+    std::shared_ptr<Flag_group> flagGroup; // 排班使用的花名册快照，执勤次数写入其中
     bool useTotalTimesRule; // 规则标签，判断是否使用总次数规则
     HandoverRule handoverRule; // 规则标签，判断是否使用交接规则
+    const SiteRegistry& registry; // 执勤地点与仪式登记表
     std::unordered_map<std::string, int> warningCount; // 键值对容器，用于记录交接规则失败警告信息出现的次数
     std::vector<Person*> availableMembers; // 容器，保存参加排班的队员
-    std::vector<std::vector<std::vector<Person*>>> scheduleTable; // 工作表格
+    ScheduleTable scheduleTable; // 工作表格
+    bool hasSeed = false; // 是否指定了随机数种子
+    quint64 seed = 0; // 随机数种子
+    bool cacheEnabled = true; // 是否使用排班结果缓存
+    QStringList emittedWarnings; // 本次排班发出的警告，随结果一起缓存
+
+    // 缓存键：排班规则、种子、执勤地点与仪式登记表，以及参加排班队员（按组别顺序）的队员编号、执勤时间，
+    // 采用总次数规则时还包括总执勤次数，取SHA-256摘要
+    // 本周执勤次数在排班开始时清零，不影响结果，不计入
+    std::string fingerprint() const {
+        // 缓存为全程序共用，各单位的队员编号都从1开始，登记表不同的单位必须得到不同的键
+        std::string key = std::to_string(useTotalTimesRule) + '|' + std::to_string(handoverRule) + '|' + std::to_string(seed) + '\x1e'
+                          + registry.signature() + '\x1e';
+        for (const Person* person : availableMembers) {
+            key += std::to_string(person->getId());
+            key += '\x1f';
+            key += std::to_string(person->getTimeBits()); // 整张执勤时间表
+            if (useTotalTimesRule) {
+                key += '\x1f'; // 与执勤时间分隔，否则执勤时间12、总次数3与执勤时间1、总次数23得到相同的键
+                key += std::to_string(person->getAll_times());
+            }
+            key += '\x1e';
+        }
+        // 缓存中只保存摘要，键的长度与人数无关
+        QByteArray digest = QCryptographicHash::hash(QByteArray::fromStdString(key), QCryptographicHash::Sha256);
+        return digest.toStdString();
+    }
+    // 复用缓存的排班结果：按下标找回队员填入工作表格，更新执勤次数，并重新发出原来的警告
+    void applyCachedResult(const ScheduleCache::Entry& entry) {
+        scheduleTable.clear();
+        for (int seat = 0; seat < scheduleTable.seatCount(); ++seat) {
+            if (entry.seats[seat] < 0) {
+                continue;
+            }
+            Person* person = availableMembers[entry.seats[seat]];
+            int position = seat % ScheduleTable::peoplePerLocation;
+            int location = seat / ScheduleTable::peoplePerLocation % scheduleTable.siteCount();
+            int slot = seat / ScheduleTable::peoplePerLocation / scheduleTable.siteCount();
+            scheduleTable.set(slot, location, position, person);
+            person->setTimes(person->getTimes() + 1);
+            person->setAll_times(person->getAll_times() + 1);
+        }
+        for (const QString& warning : entry.warnings) {
+            emittedWarnings << warning;
+            emit schedulingWarning(warning);
+        }
+    }
 
     void initializeAvailableMembers() {
         // 初始化辅助函数
         // 通过队员的isWork的信息统计参加排班的人
         for (int group = 1; group <= 4; ++group) {
-            const auto& members = flagGroup.getGroupMembers(group);
-            for (const auto& member : members) {
+            auto& members = flagGroup->getGroupMembers(group); // 快照归本管理器所有，可以直接修改
+            for (auto& member : members) {
                 if (member.getIsWork()) {
-                    availableMembers.push_back(const_cast<Person*>(&member));
+                    availableMembers.push_back(&member);
                 }
             }
         }
@@ -136,6 +318,7 @@ private:
     Person* selectPerson(int slot, int timeRow,int location, int day) {
         // 制表辅助函数
         // 选择合适的可工作队员
+        // 以下取值范围均为默认登记表下的值，实际由执勤地点与仪式登记表决定
         // slot=0~9，表示10个时间段（周一上午、周一下午、周二上午、周二下午…… 周五下午）
         // timeRow=1~4，表格行数，分别表示NJH升旗，DXY升旗，NJH降旗，DXY降旗
         // location=0~1，工作地点，分别表示南鉴湖，东西院
@@ -169,21 +352,15 @@ private:
             }
         }
 
-        // 警告信息临时变量
-        std::string days[] = { "周一", "周二", "周三", "周四", "周五" };
-        std::string halves[] = { "上午", "下午" };
-        std::string locations[] = { "NJH", "DXY" };
-        int dayIndex = (slot / 2);
-        int halfDayIndex = (slot % 2);
-
         // 如果无法完成交接规则，将发出警报，放弃交接规则，重新选人
         // 考虑到每次任务有三名队员，交接规则原则上最少只需要有一个队员完成交接即可，所以需要当一次任务的三个队员都不符合交接规则时才发送警告信息
         // 生成无法完成交接规则的警告信息
-        std::string warning = "警告：在 " + days[dayIndex] + " " + halves[halfDayIndex] + " " + locations[location] + " 无法完成交接规则。";
+        std::string warning = "警告：在 " + registry.crewLabel(slot, location) + " 无法完成交接规则。";
         // 增加该警告信息的计数
         warningCount[warning]++;
         // 当警告信息出现三次时才发送
         if (warningCount[warning] == 3) {
+            emittedWarnings << QString::fromStdString(warning);
             emit schedulingWarning(QString::fromStdString(warning));
         }
 
@@ -197,30 +374,42 @@ private:
             }
         }
         // 普通筛选仍无法找到合适队员，系统将发送警告信息
-        warning = "警告：在 " + days[dayIndex] + " " + halves[halfDayIndex] + " " + locations[location] + " 无法选出合适的人员进行排班。";
+        warning = "警告：在 " + registry.crewLabel(slot, location) + " 无法选出合适的人员进行排班。";
+        emittedWarnings << QString::fromStdString(warning);
         emit schedulingWarning(QString::fromStdString(warning));
         return nullptr;
     }
     // 判断是否已经在同一时间段安排了工作
     bool isPersonBusy(Person* person, int slot) const {
-        // 将对应时间段slot的所有位置都遍历一遍，查看是否已经存在该队员person
-        for (int location = 0; location < 2; ++location) {
-            for (int position = 0; position < 3; ++position) {
-                if (scheduleTable[slot][location][position] == person) {
-                    return true;
-                }
+        // 将对应时间段slot的所有位置（两个地点共6个相邻岗位）都遍历一遍，查看是否已经存在该队员person
+        for (Person* seated : scheduleTable.slotSeats(slot)) {
+            if (seated == person) {
+                return true;
             }
         }
         return false;
     }
 
+    // 时间段slot的第一个地点是否需要与前一天最后一个仪式交接：MondayHandoverRule只有周二第一个仪式，
+    // AllHandoverRule为周二起每天的第一个仪式
+    bool isHandoverSlot(int slot) const {
+        switch (handoverRule) {
+            case MondayHandoverRule:
+                return slot == registry.ceremonyCount();
+            case AllHandoverRule:
+                return slot > 0 && registry.slotHalfDay(slot) == 0;
+            case NoRule:
+                return false;
+        }
+        return false;
+    }
     // 判断人员是否满足交接规则
     bool isPersonSatisfyHandoverRule(Person* person, int slot, int location) {
         switch (handoverRule) {
             case MondayHandoverRule: // 仅周二的南鉴湖升旗采用交接规则
             {
-                if (slot == 2 && location == 0) { // 对应表格一行二列，周二南鉴湖升旗
-                    auto& firstColumn = scheduleTable[1][0];// 对应表格三行一列，周一南鉴湖降旗
+                if (isHandoverSlot(slot) && location == 0) { // 对应表格一行二列，周二南鉴湖升旗
+                    SeatView firstColumn = scheduleTable.crew(slot - 1, 0);// 对应表格三行一列，周一南鉴湖降旗
                     for (auto member : firstColumn) {
                         if (member == person) {
                             return true;
@@ -232,12 +421,11 @@ private:
             }
             case AllHandoverRule: // 全周（周二至周五）南鉴湖升旗采用交接规则
             {
-                int currentCol = slot % 2;//值为0~1,检查当前是否为升旗时间段
-                if (currentCol == 0 && !location && slot)
-                // currentCol == 0:当前为升旗任务  !location == 1:当前为南鉴湖任务  slot != 0:当前不是周一升旗任务
+                if (isHandoverSlot(slot) && !location)
+                // 当天第一个仪式（升旗）、第一个地点（南鉴湖），且不是周一
                 // 所以，能进入if语句内的条件是：周二到周五的南鉴湖升旗任务
                 {
-                    auto& prevColumn = scheduleTable[slot-1][location];//前一天南鉴湖降旗情况
+                    SeatView prevColumn = scheduleTable.crew(slot - 1, location);//前一天南鉴湖降旗情况
                     // 查看该队员是否安排在前一天南鉴湖降旗任务中
                     for (auto member : prevColumn) {
                         if (member == person) {
@@ -267,10 +455,10 @@ inline void SchedulingManager::setUseTotalTimesRule(bool newUseTotalTimesRule)
 
 inline const Flag_group &SchedulingManager::getFlagGroup() const
 {
-    return flagGroup;
+    return *flagGroup;
 }
 
-inline std::vector<Person *> SchedulingManager::getAvailableMembers() const
+inline const std::vector<Person *> &SchedulingManager::getAvailableMembers() const
 {
     return availableMembers;
 }
@@ -280,12 +468,12 @@ inline void SchedulingManager::setAvailableMembers(const std::vector<Person *> &
     availableMembers = newAvailableMembers;
 }
 
-inline std::vector<std::vector<std::vector<Person *> > > SchedulingManager::getScheduleTable() const
+inline const ScheduleTable &SchedulingManager::getScheduleTable() const
 {
     return scheduleTable;
 }
 
-inline void SchedulingManager::setScheduleTable(const std::vector<std::vector<std::vector<Person *> > > &newScheduleTable)
+inline void SchedulingManager::setScheduleTable(const ScheduleTable &newScheduleTable)
 {
     scheduleTable = newScheduleTable;
 }
@@ -299,3 +487,62 @@ inline void SchedulingManager::setHandoverRule(SchedulingManager::HandoverRule n
 {
     handoverRule = newHandoverRule;
 }
+
+// 排班结果检查函数
+// 逐项检查：
+// 1. 上岗队员都是参加排班的队员（isWork）
+// 2. 同一时间段内（全部地点的岗位，默认两个地点共六个）没有队员重复上岗，与isPersonBusy的判定一致
+// 3. 上岗队员在该时间、地点确实有空（time数组）
+// 4. 每名参加排班队员的本周执勤次数与其在表中出现的次数一致
+// 5. 需要交接的南鉴湖升旗任务中，只要前一天南鉴湖降旗的队员有空，就必须被安排在该任务中（交接规则可行时必须满足）
+inline QStringList SchedulingManager::checkInvariants() const
+{
+    QStringList violations;
+    auto isAvailable = [this](const Person* person) {
+        return std::find(availableMembers.begin(), availableMembers.end(), person) != availableMembers.end();
+    };
+    std::unordered_map<const Person*, int> seatCount; // 每名队员在表中出现的次数
+    for (int slot = 0; slot < scheduleTable.slotCount(); ++slot) {
+        int day = registry.slotDay(slot);
+        std::vector<const Person*> seated; // 该时间段已经出现的队员
+        for (int location = 0; location < scheduleTable.siteCount(); ++location) {
+            int timeRow = registry.timeRow(slot, location);
+            for (int position = 0; position < ScheduleTable::peoplePerLocation; ++position) {
+                const Person* person = scheduleTable.at(slot, location, position);
+                if (!person) {
+                    continue;
+                }
+                QString seat = QString("时间段%1 地点%2 岗位%3 的%4").arg(slot).arg(location).arg(position).arg(QString::fromStdString(person->getName()));
+                if (!isAvailable(person)) {
+                    violations << seat + "未参加排班";
+                }
+                if (std::find(seated.begin(), seated.end(), person) != seated.end()) {
+                    violations << seat + "在同一时间段重复上岗";
+                }
+                if (!person->getTime(timeRow, day)) {
+                    violations << seat + "在该时间没有空";
+                }
+                seated.push_back(person);
+                seatCount[person]++;
+            }
+        }
+    }
+    for (const Person* person : availableMembers) {
+        if (seatCount[person] != person->getTimes()) {
+            violations << QString::fromStdString(person->getName()) + "的本周执勤次数与工作表格不一致";
+        }
+    }
+    for (int slot = 1; slot < scheduleTable.slotCount(); ++slot) {
+        if (!isHandoverSlot(slot)) {
+            continue;
+        }
+        int day = registry.slotDay(slot);
+        SeatView crew = scheduleTable.crew(slot, 0); // 当天南鉴湖升旗
+        for (const Person* previous : scheduleTable.crew(slot - 1, 0)) { // 前一天南鉴湖降旗
+            if (previous && previous->getTime(registry.timeRow(slot, 0), day) && std::find(crew.begin(), crew.end(), previous) == crew.end()) {
+                violations << QString("时间段%1 南鉴湖升旗可以完成交接，但%2未被安排").arg(slot).arg(QString::fromStdString(previous->getName()));
+            }
+        }
+    }
+    return violations;
+}
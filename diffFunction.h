@@ -0,0 +1,246 @@
+// diffFunction.h头文件
+// 功能说明：比较两次排班结果的差异ScheduleDiff
+// 工作表格中的队员指针在队员增删后会失效，不能跨两次排班保存，因此先用MemberHandles把队员换成整数编号，
+// 把一次排班保存为全部岗位（默认60个）的编号快照ScheduleSnapshot，再逐岗位、逐队员比较两份快照：
+// 某任务（时间段+地点）新增的队员、被撤下的队员、从一个任务调到另一个任务的队员、两名队员互换任务
+// 比较只遍历一遍岗位，代价与岗位数成正比；受影响的队员列表可用于只通知排班有变化的队员
+
+#pragma once
+
+#include <QFile>
+#include <QString>
+#include <QStringList>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include "Person.h"
+#include "dataFunction.h"
+#include "siteFunction.h"
+
+// MemberHandles 类定义，队员编号表
+// 以队员编号识别队员（与Flag_group的判定规则一致），同一队员始终得到同一编号，改名后仍是同一编号
+class MemberHandles
+{
+public:
+    // 返回队员的编号，第一次出现时分配新编号；队员改名后记下新的姓名
+    int handleOf(const Person& person) {
+        auto it = handles.find(person.getId());
+        if (it != handles.end()) {
+            names[it->second] = QString::fromStdString(person.getName());
+            return it->second;
+        }
+        int handle = static_cast<int>(names.size());
+        handles.emplace(person.getId(), handle);
+        names.push_back(QString::fromStdString(person.getName()));
+        return handle;
+    }
+    // 编号对应的队员姓名
+    const QString& nameOf(int handle) const { return names[handle]; }
+
+private:
+    std::unordered_map<int, int> handles; // 队员编号 -> 编号
+    std::vector<QString> names; // 编号 -> 姓名
+};
+
+// 一次排班结果的快照，每个岗位保存队员编号，-1表示空岗；岗位编号与ScheduleTable::index一致
+struct ScheduleSnapshot
+{
+    std::vector<int> seats;
+    int locations = 0; // 每个时间段的地点数
+    bool valid = false; // 是否已保存过排班结果
+
+    static ScheduleSnapshot of(const ScheduleTable& table, MemberHandles& handles) {
+        ScheduleSnapshot snapshot;
+        SeatView allSeats = table.allSeats();
+        snapshot.seats.resize(allSeats.size());
+        snapshot.locations = table.siteCount();
+        for (int seat = 0; seat < allSeats.size(); ++seat) {
+            snapshot.seats[seat] = allSeats[seat] ? handles.handleOf(*allSeats[seat]) : -1;
+        }
+        snapshot.valid = true;
+        return snapshot;
+    }
+};
+
+// ScheduleDiff 类定义，两次排班结果的差异
+class ScheduleDiff
+{
+public:
+    // 发生变化的岗位
+    struct SeatChange {
+        int seat; // 岗位编号
+        int before; // 原队员编号，-1为空岗
+        int after; // 新队员编号，-1为空岗
+    };
+    // 队员的一项变动
+    enum ChangeType {
+        Added, // 新增执勤：member 加入 to 任务
+        Removed, // 撤下执勤：member 离开 from 任务
+        Moved, // 调整：member 从 from 任务调到 to 任务
+        Swapped // 互换：member 从 from 调到 to，other 从 to 调到 from
+    };
+    struct Change {
+        ChangeType type;
+        int member; // 队员编号
+        int from; // 原任务编号（时间段 * 地点数 + 地点），新增时为-1
+        int to; // 新任务编号，撤下时为-1
+        int other; // 互换的另一名队员编号，其余情况为-1
+    };
+
+    // 比较两份快照，两次排班的时间段数或地点数不同（登记表已改变）时无法比较
+    static ScheduleDiff compute(const ScheduleSnapshot& before, const ScheduleSnapshot& after) {
+        ScheduleDiff diff;
+        if (before.seats.size() != after.seats.size() || before.locations != after.locations) {
+            return diff;
+        }
+        diff.computed = true;
+        diff.locations = after.locations;
+        const int people = ScheduleTable::peoplePerLocation;
+        const int crewCount = static_cast<int>(after.seats.size()) / people; // 任务数
+        diff.changedCrews.assign(crewCount, false);
+        // 逐岗位比较
+        for (int seat = 0; seat < static_cast<int>(after.seats.size()); ++seat) {
+            if (before.seats[seat] != after.seats[seat]) {
+                diff.seats.push_back({seat, before.seats[seat], after.seats[seat]});
+            }
+        }
+        // 逐任务比较成员，任务内岗位顺序不同不算变化
+        std::vector<int> order; // 有变动的队员，按首次出现的顺序
+        std::unordered_map<int, std::pair<std::vector<int>, std::vector<int>>> crews; // 队员 -> （离开的任务，加入的任务）
+        auto contains = [people](const int* crew, int member) {
+            return std::find(crew, crew + people, member) != crew + people;
+        };
+        for (int crew = 0; crew < crewCount; ++crew) {
+            const int* oldCrew = &before.seats[crew * people];
+            const int* newCrew = &after.seats[crew * people];
+            for (int position = 0; position < people; ++position) {
+                int removed = oldCrew[position];
+                if (removed >= 0 && !contains(newCrew, removed)) {
+                    auto inserted = crews.try_emplace(removed);
+                    if (inserted.second) {
+                        order.push_back(removed);
+                    }
+                    inserted.first->second.first.push_back(crew);
+                    diff.changedCrews[crew] = true;
+                }
+                int added = newCrew[position];
+                if (added >= 0 && !contains(oldCrew, added)) {
+                    auto inserted = crews.try_emplace(added);
+                    if (inserted.second) {
+                        order.push_back(added);
+                    }
+                    inserted.first->second.second.push_back(crew);
+                    diff.changedCrews[crew] = true;
+                }
+            }
+        }
+        // 同一队员离开一个任务、加入另一个任务，记为调整；剩余的记为撤下或新增
+        std::unordered_map<long long, std::vector<size_t>> moves; // （原任务，新任务） -> 尚未配对的调整
+        auto moveKey = [crewCount](int from, int to) { return static_cast<long long>(from) * crewCount + to; };
+        for (int member : order) {
+            const auto& entry = crews[member];
+            const std::vector<int>& left = entry.first;
+            const std::vector<int>& joined = entry.second;
+            size_t paired = std::min(left.size(), joined.size());
+            for (size_t i = 0; i < paired; ++i) {
+                // 已有一名队员反方向调整时，两人合并为一次互换
+                auto reverse = moves.find(moveKey(joined[i], left[i]));
+                if (reverse != moves.end() && !reverse->second.empty()) {
+                    Change& counterpart = diff.changeList[reverse->second.back()];
+                    reverse->second.pop_back();
+                    counterpart.type = Swapped;
+                    counterpart.other = member;
+                    continue;
+                }
+                moves[moveKey(left[i], joined[i])].push_back(diff.changeList.size());
+                diff.changeList.push_back({Moved, member, left[i], joined[i], -1});
+            }
+            for (size_t i = paired; i < left.size(); ++i) {
+                diff.changeList.push_back({Removed, member, left[i], -1, -1});
+            }
+            for (size_t i = paired; i < joined.size(); ++i) {
+                diff.changeList.push_back({Added, member, -1, joined[i], -1});
+            }
+        }
+        diff.members = order;
+        return diff;
+    }
+
+    bool isComputed() const { return computed; } // 是否有可比较的上一次排班
+    bool isEmpty() const { return seats.empty(); } // 两次排班完全相同
+    const std::vector<SeatChange>& seatChanges() const { return seats; }
+    const std::vector<Change>& changes() const { return changeList; }
+    // 某任务的成员是否有变化，用于在工作表格中标出
+    bool crewChanged(int slot, int location) const { return computed && changedCrews[slot * locations + location]; }
+    // 排班有变化的队员编号，可只通知这些队员
+    const std::vector<int>& affectedMembers() const { return members; }
+
+    // 每项变动的说明文字
+    QStringList describe(const MemberHandles& handles, const SiteRegistry& registry) const {
+        QStringList lines;
+        for (const Change& change : changeList) {
+            const QString& name = handles.nameOf(change.member);
+            switch (change.type) {
+            case Added:
+                lines << "新增：" + name + " " + crewText(change.to, registry);
+                break;
+            case Removed:
+                lines << "撤下：" + name + " " + crewText(change.from, registry);
+                break;
+            case Moved:
+                lines << "调整：" + name + " " + crewText(change.from, registry) + " → " + crewText(change.to, registry);
+                break;
+            case Swapped:
+                lines << "互换：" + name + "（" + crewText(change.from, registry) + "）↔ " + handles.nameOf(change.other)
+                             + "（" + crewText(change.to, registry) + "）";
+                break;
+            }
+        }
+        return lines;
+    }
+    // 导出为CSV文件（UTF-8，带BOM以便Excel正确识别中文），返回是否成功
+    // 按RFC 4180书写：记录以CRLF结尾，含逗号、引号或换行的字段（如带逗号的姓名、地点名）加引号，字段中的引号写两次
+    bool exportCsv(const QString& filename, const MemberHandles& handles, const SiteRegistry& registry) const {
+        static const char* typeNames[] = {"新增", "撤下", "调整", "互换"};
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+            return false;
+        }
+        QString text = "类型,队员,原任务,新任务,互换队员\r\n";
+        for (const Change& change : changeList) {
+            text += csvField(typeNames[change.type]) + "," + csvField(handles.nameOf(change.member)) + ","
+                    + csvField(change.from >= 0 ? crewText(change.from, registry) : QString()) + ","
+                    + csvField(change.to >= 0 ? crewText(change.to, registry) : QString()) + ","
+                    + csvField(change.other >= 0 ? handles.nameOf(change.other) : QString()) + "\r\n";
+        }
+        QByteArray bytes = "\xEF\xBB\xBF" + text.toUtf8();
+        bool ok = file.write(bytes) == bytes.size();
+        file.close();
+        return ok;
+    }
+
+private:
+    bool computed = false; // 是否由compute得到
+    std::vector<SeatChange> seats; // 发生变化的岗位
+    std::vector<Change> changeList; // 队员变动
+    std::vector<int> members; // 受影响的队员
+    int locations = 0; // 每个时间段的地点数
+    std::vector<bool> changedCrews; // 各任务的成员是否有变化
+
+    // CSV字段：含逗号、引号或换行时加引号，字段中的引号写两次
+    static QString csvField(const QString& text) {
+        if (!text.contains(',') && !text.contains('"') && !text.contains('\n') && !text.contains('\r')) {
+            return text;
+        }
+        QString quoted = text;
+        quoted.replace("\"", "\"\"");
+        return "\"" + quoted + "\"";
+    }
+    // 任务的说明文字，如“周二 南鉴湖升旗”
+    static QString crewText(int crew, const SiteRegistry& registry) {
+        int slot = crew / registry.siteCount();
+        int location = crew % registry.siteCount();
+        return registry.dayName(registry.slotDay(slot) - 1) + " " + registry.rowLabel(registry.timeRow(slot, location));
+    }
+};
@@ -1,90 +1,726 @@
 // fileFunction.h头文件
 // 功能说明：对数据进行文件读写操作，实现队员信息写入文件，从文件中读取队员信息，从而提升系统的复用性
+// 数据文件保持纯文本，便于花名册服务、多单位排班直接读取，也便于按位置延迟读取档案、原位覆盖修改过的记录；
+// 每次整体重写前的原文件压缩后轮换保存在backup文件夹中；原位覆盖前先把新旧记录写入日志文件，中途断电时下次读取可以补完
 
 #pragma once
+#include <algorithm>
 #include <string>
+#include <memory>
+#include <vector>
+#include <limits>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
 #include <QFile>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDir>
 #include <QTextStream>
+#include <QStringView>
 #include <QDebug>
 #include "Flag_group.h"
+#ifdef Q_OS_WIN
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+// 数据文件档案来源
+// 按读取文件时记录的行首位置，重新读出该行并解析其中的档案字段（电话、籍贯、民族、寝室、学院、生日）
+// 行首位置只在读取时的那一版文件中有效，而撤销记录中的队员（如已删除的队员）可能在文件改写后才第一次读取档案：
+// 本程序原位覆盖记录前通过preserve保留覆盖前的记录；整体重写时通过replace把档案仍在新文件中的位置改为新位置，
+// 只把不在新文件中、又尚未读取的少数档案记录留在内存中，不保留整个原文件
+// 文件被其他程序改动（大小或修改时间与读取时不同）时拒绝按位置读取，不会读到另一名队员的档案
+class FileProfileSource : public ProfileSource
+{
+public:
+    using Identity = std::pair<qint64, qint64>; // 文件大小与修改时间（毫秒），用于发现文件被其他程序改动
+
+    // 建立并登记一个档案来源，读取数据文件时调用
+    static std::shared_ptr<const FileProfileSource> create(const QString& filename) {
+        std::shared_ptr<FileProfileSource> source(new FileProfileSource(filename));
+        std::lock_guard<std::mutex> lock(registryMutex());
+        auto& list = registry();
+        for (size_t i = 0; i < list.size();) { // 顺带清除已释放的档案来源
+            if (list[i].expired()) {
+                list[i] = list.back();
+                list.pop_back();
+            } else {
+                ++i;
+            }
+        }
+        list.push_back(source);
+        return source;
+    }
+    PersonProfile loadProfile(long long offset) const override {
+        // 与preserve、replace互斥：要么在文件改动前读完，要么读到保留下来的原记录或新位置
+        std::lock_guard<std::mutex> lock(registryMutex());
+        served.insert(offset);
+        QByteArray line;
+        qint64 position = positionOf(offset);
+        auto kept = retained.find(offset);
+        auto patched = overlay.find(position);
+        if (kept != retained.end()) {
+            line = kept->second;
+        } else if (patched != overlay.end()) {
+            line = patched->second;
+        } else if (position < 0) {
+            return PersonProfile();
+        } else if (identityOf(filename) != identity) {
+            qWarning() << "数据文件" << filename << "已被其他程序改动，无法读取档案信息";
+            return PersonProfile();
+        } else {
+            QFile file(filename); // 每次读取单独打开文件，可在任意线程调用
+            if (file.open(QIODevice::ReadOnly) && file.seek(position)) {
+                line = file.readLine();
+            }
+        }
+        return profileOf(line);
+    }
+    // 尚未读取的档案在数据文件当前内容中的行首位置，整体重写时据此原样复制档案字段
+    // 参数：path：数据文件的绝对路径。current：数据文件当前的大小与修改时间（identityOf），调用方对全部队员只取一次
+    // 不是该文件的档案、文件已被其他程序改动、档案记录已被原位覆盖或已不在当前文件中时返回-1
+    qint64 locate(const QString& path, const Identity& current, long long offset) const {
+        std::lock_guard<std::mutex> lock(registryMutex());
+        if (path != filename || current != identity || retained.count(offset)) {
+            return -1;
+        }
+        qint64 position = positionOf(offset);
+        return overlay.count(position) ? -1 : position;
+    }
+    // 数据文件offset处的记录即将被原位覆盖：保留覆盖前的记录。同一位置只保留第一次覆盖前（读取时）的记录
+    static void preserve(const QString& filename, qint64 offset, const QByteArray& record) {
+        forEachLive(filename, [offset, &record](FileProfileSource& source) {
+            source.overlay.emplace(offset, record);
+        });
+    }
+    // 本程序原位覆盖完成后调用，记下改动后的文件大小与修改时间，不把本程序的改动当作其他程序的改动
+    static void refresh(const QString& filename) {
+        auto current = identityOf(filename);
+        forEachLive(filename, [&current](FileProfileSource& source) {
+            source.identity = current;
+        });
+    }
+    // 整体替换数据文件：调用commit完成替换，成功后更新该文件全部档案来源的档案位置，返回commit的结果
+    // 参数：original：替换前的文件内容。moved：原样复制到新文件的记录，原文件中的行首位置 -> 新文件中的行首位置
+    // 替换与更新在同一次加锁中完成，其他线程不会在两者之间按旧位置读取新文件
+    static bool replace(const QString& filename, const QByteArray& original, const std::unordered_map<qint64, qint64>& moved,
+                        const std::function<bool()>& commit) {
+        QString path = QFileInfo(filename).absoluteFilePath();
+        std::lock_guard<std::mutex> lock(registryMutex());
+        Identity before = identityOf(path);
+        if (!commit()) {
+            return false;
+        }
+        Identity after = identityOf(path);
+        for (const auto& weak : registry()) {
+            auto source = weak.lock();
+            if (!source || source->filename != path || source->identity != before) {
+                continue; // 其他文件的档案来源，或原文件已被其他程序改动，original与其记录的位置不对应
+            }
+            std::unordered_map<qint64, qint64> positions;
+            // 尚未读取的档案：记录原样出现在新文件中时改为新位置，否则把记录留在内存中
+            auto carry = [&](qint64 offset, qint64 position) {
+                if (source->served.count(offset)) {
+                    return;
+                }
+                auto patched = source->overlay.find(position);
+                auto target = moved.find(position);
+                if (patched != source->overlay.end()) {
+                    source->retained.emplace(offset, patched->second);
+                } else if (target != moved.end()) {
+                    positions.emplace(offset, target->second);
+                } else {
+                    source->retained.emplace(offset, lineAt(original, position));
+                }
+            };
+            if (source->relocated) {
+                for (const auto& entry : source->positions) {
+                    carry(entry.first, entry.second);
+                }
+            } else {
+                for (qint64 position = 0; position < original.size();) {
+                    qint64 end = original.indexOf('\n', position);
+                    end = end < 0 ? original.size() : end;
+                    if (original.mid(position, end - position).count('|') >= 10 + 20 + 2) { // 只保留队员记录行
+                        carry(position, position);
+                    }
+                    position = end + 1;
+                }
+            }
+            for (auto it = source->retained.begin(); it != source->retained.end();) { // 留在内存中又已读取的记录
+                it = source->served.count(it->first) ? source->retained.erase(it) : std::next(it);
+            }
+            source->positions.swap(positions);
+            source->relocated = true;
+            source->overlay.clear(); // 覆盖前的记录已按需转入retained
+            source->served.clear(); // 已读取的档案不会再读取，其位置都已丢弃
+            source->identity = after;
+        }
+        return true;
+    }
+    // 取出content中offset处的一行，不含行尾的换行符
+    static QByteArray lineAt(const QByteArray& content, qint64 offset) {
+        qint64 end = content.indexOf('\n', offset);
+        QByteArray line = content.mid(offset, end < 0 ? -1 : end - offset);
+        while (line.endsWith('\r')) {
+            line.chop(1);
+        }
+        return line;
+    }
+    static Identity identityOf(const QString& filename) {
+        QFileInfo info(filename);
+        return {info.size(), info.lastModified().toMSecsSinceEpoch()};
+    }
+
+private:
+    QString filename; // 数据文件名
+    // 以下成员由registryMutex保护
+    Identity identity; // 读取时（或本程序最近一次改写后）文件的大小与修改时间
+    bool relocated = false; // 文件是否被本程序整体重写过，重写后档案的位置由positions给出
+    std::unordered_map<qint64, qint64> positions; // 整体重写后：读取时的行首位置 -> 当前文件中的行首位置
+    std::unordered_map<qint64, QByteArray> overlay; // 当前文件中原位覆盖前的记录：当前文件中的行首位置 -> 记录
+    std::unordered_map<qint64, QByteArray> retained; // 已不在当前文件中、尚未读取的档案记录：读取时的行首位置 -> 记录
+    mutable std::unordered_set<qint64> served; // 已读取的档案（读取时的行首位置），每份档案只读取一次，整体重写时不必保留
+
+    explicit FileProfileSource(const QString& filename)
+        : filename(QFileInfo(filename).absoluteFilePath()), identity(identityOf(filename)) {}
+    static std::mutex& registryMutex() {
+        static std::mutex mutex;
+        return mutex;
+    }
+    static std::vector<std::weak_ptr<FileProfileSource>>& registry() {
+        static std::vector<std::weak_ptr<FileProfileSource>> sources; // 全部档案来源
+        return sources;
+    }
+    // 对该文件的档案来源逐一调用action
+    static void forEachLive(const QString& filename, const std::function<void(FileProfileSource&)>& action) {
+        QString path = QFileInfo(filename).absoluteFilePath();
+        std::lock_guard<std::mutex> lock(registryMutex());
+        for (const auto& weak : registry()) {
+            auto source = weak.lock();
+            if (source && source->filename == path) {
+                action(*source);
+            }
+        }
+    }
+    // 读取时的行首位置 -> 当前文件中的行首位置，档案已不在当前文件中时返回-1。调用方持有registryMutex
+    qint64 positionOf(long long offset) const {
+        if (!relocated) {
+            return offset;
+        }
+        auto it = positions.find(offset);
+        return it == positions.end() ? -1 : it->second;
+    }
+    // 从一行记录中解析档案字段，字段数不对时返回空档案
+    static PersonProfile profileOf(const QByteArray& bytes) {
+        PersonProfile profile;
+        QString line = QString::fromUtf8(bytes);
+        while (line.endsWith('\n') || line.endsWith('\r')) {
+            line.chop(1);
+        }
+        QStringList parts = line.split("|");
+        if (parts.size() >= 10 + 20 + 3 && parts.size() <= 10 + 20 + 5) {
+            profile.phone_number = parts[3].toStdString(); // 联系电话
+            profile.native_place = parts[4].toStdString(); // 籍贯
+            profile.native = parts[5].toStdString(); // 民族
+            profile.dorm = parts[6].toStdString(); // 寝室号
+            profile.school = parts[7].toStdString(); // 学院
+            profile.birthday = parts[9].toStdString(); // 生日
+        }
+        return profile;
+    }
+};
+
 class FlagGroupFileManager
 {
 public:
+    // 整体写入文件的结果，由writeSnapshot在任意线程得到，再由applySaveResult在花名册所在线程应用
+    struct SaveResult {
+        bool ok = false; // 是否写入成功
+        qint64 fileSize = 0; // 写入后的文件大小
+        std::vector<std::pair<qint64, int>> records; // 各队员记录的位置与长度，按组别、组内顺序排列
+    };
+    static constexpr int backupCount = 5; // 保留的压缩备份数
+
     // 文件写入函数，将队员信息保存至文件中
-    static void saveToFile(const Flag_group& flagGroup, const QString& filename) {
+    // 读取或上次保存后没有任何修改时直接返回；只修改了部分队员且这些队员的记录长度不变时，只覆盖这几条记录；
+    // 否则整体重写文件。在调用线程中完成，窗口运行期间的保存由RosterSaver放到后台线程（见saveFunction.h）
+    static void saveToFile(Flag_group& flagGroup, const QString& filename) {
         // 参数：Flag_group：存放国旗班所有队员信息的容器。QString filename：文件名
-        QFile file(filename); // 创建QFile对象
-        if (file.open(QIODevice::WriteOnly | QIODevice::Text)) // 检查写入文件是否能访问
-        {
-            QTextStream out(&file);// 打开数据文件，准备写入
-            for (int i = 1; i <= 4; ++i) { // 循环，完成全部四组的队员数据写入
-                const auto& members = flagGroup.getGroupMembers(i);// 获取某一组的全部队员信息
-                for (const auto& person : members) {// 依次写入某一个队员的全部信息
-                    out << QString::fromStdString(person.getName()) << "|" // 姓名
-                        << (person.getGender() ? "1" : "0") << "|" // 性别
-                        << person.getGroup() << "|" // 所属组别
-                        << QString::fromStdString(person.getPhone_number()) << "|" // 联系电话
-                        << QString::fromStdString(person.getNative_place()) << "|" // 籍贯
-                        << QString::fromStdString(person.getNative()) << "|" // 民族
-                        << QString::fromStdString(person.getDorm()) << "|" // 寝室号
-                        << QString::fromStdString(person.getSchool()) << "|" // 学院
-                        << QString::fromStdString(person.getClassname()) << "|" // 专业班级
-                        << QString::fromStdString(person.getBirthday()) << "|" // 生日
-                        << (person.getIsWork() ? "1" : "0") << "|"; // 是否参与排班
-                    for (int j = 1; j < 5; ++j) {
-                        for (int k = 1; k < 6; ++k) {
-                            out << (person.getTime(j, k) ? "1" : "0") << "|"; // 时间安排表
-                        }
-                    }
-                    out << person.getTimes() << "|" // 本次执勤次数
-                        << person.getAll_times() << "\n"; // 总执勤次数
+        if (!flagGroup.isDirty()) {
+            return;
+        }
+        if (patchFile(flagGroup, filename)) {
+            return;
+        }
+        long long revision = flagGroup.getLayoutRevision();
+        applySaveResult(flagGroup, flagGroup, revision, writeSnapshot(flagGroup, filename));
+    }
+    // 整体写入花名册，可在后台线程中对花名册快照调用
+    // 先把原文件压缩后存入备份目录，再写入同目录下的临时文件，写完并刷新到磁盘后改名替换原文件：
+    // 写入中途程序退出或断电时原文件保持完整，不会留下写了一半的数据文件
+    // 尚未读取档案的队员，档案字段直接从原文件中该队员的记录复制，不为保存逐个读出档案；原文件内容只在保存期间留在内存中
+    static SaveResult writeSnapshot(const Flag_group& flagGroup, const QString& filename) {
+        SaveResult result;
+        QByteArray originalContent;
+        QFile original(filename);
+        bool hasOriginal = original.open(QIODevice::ReadOnly); // 第一次保存时还没有原文件
+        if (hasOriginal) {
+            originalContent = original.readAll();
+            original.close();
+            backupFile(filename, originalContent);
+        }
+        QString path = QFileInfo(filename).absoluteFilePath();
+        FileProfileSource::Identity identity = FileProfileSource::identityOf(path);
+        std::unordered_map<qint64, qint64> moved; // 复制了档案字段的记录：原文件中的行首位置 -> 新文件中的行首位置
+        QByteArray content;
+        for (int i = 1; i <= 4; ++i) { // 循环，完成全部四组的队员数据写入
+            for (const auto& person : flagGroup.getGroupMembers(i)) {// 依次写入某一个队员的全部信息
+                long long profileOffset = 0;
+                auto source = dynamic_cast<const FileProfileSource*>(person.getUnloadedProfileSource(profileOffset));
+                qint64 position = hasOriginal && source ? source->locate(path, identity, profileOffset) : -1;
+                QByteArray record;
+                if (position >= 0) {
+                    QByteArray originalRecord = FileProfileSource::lineAt(originalContent, position);
+                    record = recordOf(person, &originalRecord);
                 }
+                if (record.isEmpty()) {
+                    record = recordOf(person); // 档案已在内存中，或原记录不可用时读出档案
+                } else {
+                    moved.emplace(position, content.size());
+                }
+                result.records.emplace_back(content.size(), static_cast<int>(record.size()));
+                content += record;
+                content += '\n';
             }
-            file.close();// 关闭文件
+        }
+        QSaveFile file(filename); // 写入临时文件，commit时替换原文件
+        if (file.open(QIODevice::WriteOnly)) // 以二进制方式写入，记录的位置与文件字节位置一致
+        {
+            file.write(content);
+            // 刷新到磁盘后改名替换，写入出错时放弃临时文件，原文件不变；替换成功后档案来源改按新位置读取
+            result.ok = FileProfileSource::replace(filename, originalContent, moved, [&file]() { return file.commit(); });
+            result.fileSize = content.size();
+        }
+        if (result.ok) {
+            QFile::remove(journalName(filename)); // 整体重写后，之前原位覆盖的日志不再适用
         }
         // 测试代码
-        // else {// 无法打开文件时的报错处理
-        //     qDebug() << "无法打开文件 " << filename << " 进行写入！";
+        // if (!result.ok) {// 无法写入文件时的报错处理
+        //     qDebug() << "无法写入文件 " << filename << " ：" << file.errorString();
         // }
+        return result;
+    }
+    // 应用整体写入的结果：更新各队员的记录位置，写入后未再修改的队员清除修改标记
+    // 参数：flagGroup：当前的花名册。snapshot：写入文件的花名册快照（同步保存时即flagGroup本身）
+    // snapshotRevision：取快照时flagGroup的增删次数。快照经Flag_group::operator=赋值时会增加它自己的计数，
+    // 不能用快照自身的getLayoutRevision()比较
+    static void applySaveResult(Flag_group& flagGroup, const Flag_group& snapshot, long long snapshotRevision, const SaveResult& result) {
+        if (!result.ok) {
+            return;
+        }
+        size_t memberCount = 0;
+        for (int i = 1; i <= 4; ++i) {
+            memberCount += flagGroup.getGroupMembers(i).size();
+        }
+        if (flagGroup.getLayoutRevision() == snapshotRevision && memberCount == result.records.size()) {
+            // 写入期间没有增删队员，记录与队员一一对应；人数不符时按增删处理
+            size_t index = 0;
+            for (int i = 1; i <= 4; ++i) {
+                auto& members = flagGroup.getGroupMembers(i);
+                const auto& savedMembers = snapshot.getGroupMembers(i);
+                for (size_t row = 0; row < members.size(); ++row, ++index) {
+                    const auto& record = result.records[index];
+                    if (members[row].sharesDataWith(savedMembers[row])) {
+                        members[row].markSaved(record.first, record.second);
+                    } else {
+                        members[row].moveRecord(record.first, record.second); // 写入期间又被修改，下次保存时写入
+                    }
+                }
+            }
+        }
+        flagGroup.markSaved(result.fileSize, snapshotRevision);
+    }
+    // 只覆盖修改过的队员记录，返回是否完成
+    // 增删过队员、文件在上次读取或保存后被其他程序改动、修改过的队员没有对应记录或记录长度改变时，返回false，需要整体重写
+    static bool patchFile(Flag_group& flagGroup, const QString& filename) {
+        if (flagGroup.isLayoutChanged()) {
+            return false;
+        }
+        QFile file(filename);
+        if (!file.exists() || file.size() != flagGroup.getSavedFileSize()) {
+            return false;
+        }
+        // 先生成全部新记录：生成记录时可能按位置读取尚未读取的档案，此时文件还不能改动
+        std::vector<std::pair<Person*, QByteArray>> patches;
+        for (int i = 1; i <= 4; ++i) {
+            for (auto& person : flagGroup.getGroupMembers(i)) {
+                if (!person.isDirty()) {
+                    continue;
+                }
+                if (person.getRecordOffset() < 0) {
+                    return false;
+                }
+                QByteArray record = recordOf(person);
+                if (record.size() != person.getRecordLength()) {
+                    return false;
+                }
+                patches.emplace_back(&person, record);
+            }
+        }
+        if (!file.open(QIODevice::ReadWrite)) {
+            return false;
+        }
+        // 先读出各条旧记录，连同新记录写入日志文件并刷新到磁盘，再原位覆盖：
+        // 覆盖中途程序退出或断电时，下次读取前按日志补完（见recoverJournal），不会留下新旧混杂的记录
+        QByteArray journal = QByteArray::number(file.size()) + "\n";
+        for (const auto& patch : patches) {
+            QByteArray old;
+            if (file.seek(patch.first->getRecordOffset())) {
+                old = file.read(patch.second.size());
+            }
+            if (old.size() != patch.second.size()) {
+                file.close();
+                return false; // 记录位置与文件不符，整体重写
+            }
+            // 撤销记录中尚未读取档案的队员此后从覆盖前的记录中读取
+            FileProfileSource::preserve(filename, patch.first->getRecordOffset(), old);
+            journal += QByteArray::number(patch.first->getRecordOffset()) + "\n" + old + "\n" + patch.second + "\n";
+        }
+        QSaveFile journalFile(journalName(filename));
+        if (!journalFile.open(QIODevice::WriteOnly) || journalFile.write(journal) != journal.size() || !journalFile.commit()) {
+            file.close();
+            return false; // 无法写入日志时不原位覆盖，整体重写
+        }
+        for (const auto& patch : patches) {
+            if (!file.seek(patch.first->getRecordOffset()) || file.write(patch.second) != patch.second.size()) {
+                file.close();
+                recoverJournal(filename); // 写入失败，按日志补完或还原已覆盖的记录后整体重写
+                return false;
+            }
+        }
+        bool synced = syncToDisk(file);
+        file.close();
+        if (!synced) {
+            return false; // 无法确认已写到磁盘，保留日志并整体重写
+        }
+        QFile::remove(journalName(filename));
+        FileProfileSource::refresh(filename);
+        for (const auto& patch : patches) {
+            patch.first->markSaved(patch.first->getRecordOffset(), patch.first->getRecordLength());
+        }
+        flagGroup.markSaved(flagGroup.getSavedFileSize());
+        return true;
+    }
+    // 原位覆盖的日志文件名：数据文件同目录下的“数据文件名.journal”
+    static QString journalName(const QString& filename) {
+        return filename + ".journal";
+    }
+    // 按日志补完上次中断的原位覆盖，读取数据文件前调用；没有日志时什么也不做
+    // 日志第一行为覆盖前的文件大小，之后每条记录三行：行首位置、旧记录、新记录。
+    // 只有文件大小一致、且每条记录处现有的内容为旧记录或新记录时才补写（已写入的记录不会重复写入），
+    // 否则说明文件已被整体重写或其他程序改动，日志作废。返回是否补写了记录
+    static bool recoverJournal(const QString& filename) {
+        QFile journalFile(journalName(filename));
+        if (!journalFile.open(QIODevice::ReadOnly)) {
+            return false;
+        }
+        QList<QByteArray> lines = journalFile.readAll().split('\n');
+        journalFile.close();
+        bool recovered = false;
+        QFile file(filename);
+        bool sizeOk = false;
+        qint64 fileSize = lines.isEmpty() ? -1 : lines[0].toLongLong(&sizeOk);
+        if (sizeOk && (lines.size() - 2) % 3 == 0 && file.size() == fileSize && file.open(QIODevice::ReadWrite)) {
+            std::vector<std::pair<qint64, QByteArray>> pending; // 尚未写入的记录
+            bool valid = true;
+            for (int i = 1; valid && i + 2 < lines.size(); i += 3) {
+                bool offsetOk = false;
+                qint64 offset = lines[i].toLongLong(&offsetOk);
+                const QByteArray& old = lines[i + 1];
+                const QByteArray& patched = lines[i + 2];
+                valid = offsetOk && old.size() == patched.size() && file.seek(offset);
+                if (valid) {
+                    QByteArray current = file.read(old.size());
+                    if (current == old) {
+                        pending.emplace_back(offset, patched);
+                    } else {
+                        valid = current == patched;
+                    }
+                }
+            }
+            if (valid) {
+                for (const auto& record : pending) {
+                    valid = valid && file.seek(record.first) && file.write(record.second) == record.second.size();
+                }
+                valid = valid && syncToDisk(file);
+                recovered = valid && !pending.empty();
+            }
+            file.close();
+            if (recovered) {
+                FileProfileSource::refresh(filename);
+            }
+            if (!valid) {
+                qWarning() << "数据文件与日志不符，已忽略日志" << journalName(filename);
+            }
+        }
+        QFile::remove(journalName(filename));
+        return recovered;
+    }
+    // 把已写入的数据刷新到磁盘，返回是否成功。QFile只刷新到操作系统，断电时仍可能丢失
+    static bool syncToDisk(QFile& file) {
+        if (!file.flush()) {
+            return false;
+        }
+#ifdef Q_OS_WIN
+        return _commit(file.handle()) == 0;
+#else
+        return fsync(file.handle()) == 0;
+#endif
+    }
+    // 把数据文件压缩（Qt自带的zlib）后存入同目录的backup文件夹，轮换保留最近backupCount份：
+    // data.txt.1.z为最近一份，依次后移，最旧的一份被删除。恢复时用qUncompress解压即可得到原文件
+    // 参数：filename：数据文件名。content：数据文件的内容
+    static void backupFile(const QString& filename, const QByteArray& content) {
+        QByteArray compressed = qCompress(content);
+        QFileInfo info(filename);
+        QDir dir = info.dir();
+        if (!dir.exists("backup") && !dir.mkdir("backup")) {
+            return;
+        }
+        QString base = dir.filePath("backup/" + info.fileName());
+        QFile::remove(base + QString(".%1.z").arg(backupCount));
+        for (int i = backupCount - 1; i >= 1; --i) {
+            QFile::rename(base + QString(".%1.z").arg(i), base + QString(".%1.z").arg(i + 1));
+        }
+        QSaveFile backup(base + ".1.z");
+        if (backup.open(QIODevice::WriteOnly)) {
+            backup.write(compressed);
+            backup.commit();
+        }
+    }
+    // 把姓名等任意文字转换为可用作文件名的文字：路径分隔符、Windows文件名中不允许的字符（\ / : * ? " < > |）
+    // 与控制字符替换为“_”，去掉Windows不允许的结尾空格和句点；结果为空时返回“_”
+    // 调用方再加上队员编号等唯一后缀，不会与CON、NUL等Windows保留名称重名
+    static QString safeFileName(const QString& text) {
+        QString result;
+        result.reserve(text.size());
+        for (QChar c : text) {
+            bool invalid = c.unicode() < 0x20 || c.unicode() == 0x7F || QStringLiteral("\\/:*?\"<>|").contains(c);
+            result += invalid ? QChar('_') : c;
+        }
+        while (result.endsWith(' ') || result.endsWith('.')) {
+            result.chop(1);
+        }
+        return result.isEmpty() ? QString("_") : result;
+    }
+    // 一名队员的记录，字段以“|”分隔，UTF-8编码，不含换行
+    // 第34个字段队员编号总是写出，加入队员编号之前的程序只接受33个字段，无法读取此格式的数据文件
+    // 执勤时间表固定写出默认的4行 × 5列；执勤地点、仪式或工作日更多的配置下，
+    // 队员在这20格以外也有空时，末尾再追加一个字段，以十六进制写出完整的执勤时间位（Person::getTimeBits）
+    // original：给出时档案字段（电话、籍贯、民族、寝室号、学院、生日）原样取自这条原记录，不读取队员的档案；
+    // 原记录字段数不对时返回空
+    static QByteArray recordOf(const Person& person, const QByteArray* original = nullptr) {
+        QList<QByteArray> originalFields;
+        if (original) {
+            originalFields = original->split('|');
+            if (originalFields.size() < 10 + 20 + 3 || originalFields.size() > 10 + 20 + 5) {
+                return QByteArray();
+            }
+        }
+        auto profileField = [&](int index, std::string (Person::*getter)() const) {
+            return original ? originalFields[index] : QByteArray::fromStdString((person.*getter)());
+        };
+        QByteArray record;
+        record.reserve(128);
+        record += QByteArray::fromStdString(person.getName()) + "|"; // 姓名
+        record += (person.getGender() ? "1|" : "0|"); // 性别
+        record += QByteArray::number(person.getGroup()) + "|"; // 所属组别
+        record += profileField(3, &Person::getPhone_number) + "|"; // 联系电话
+        record += profileField(4, &Person::getNative_place) + "|"; // 籍贯
+        record += profileField(5, &Person::getNative) + "|"; // 民族
+        record += profileField(6, &Person::getDorm) + "|"; // 寝室号
+        record += profileField(7, &Person::getSchool) + "|"; // 学院
+        record += QByteArray::fromStdString(person.getClassname()) + "|"; // 专业班级
+        record += profileField(9, &Person::getBirthday) + "|"; // 生日
+        record += (person.getIsWork() ? "1|" : "0|"); // 是否参与排班
+        for (int j = 1; j < 5; ++j) {
+            for (int k = 1; k < 6; ++k) {
+                record += (person.getTime(j, k) ? "1|" : "0|"); // 时间安排表
+            }
+        }
+        record += QByteArray::number(person.getTimes()) + "|"; // 本次执勤次数
+        record += QByteArray::number(person.getAll_times()) + "|"; // 总执勤次数
+        record += QByteArray::number(person.getId()); // 队员编号
+        if (person.getTimeBits() & ~legacyTimeBits()) {
+            record += "|" + QByteArray::number(static_cast<qulonglong>(person.getTimeBits()), 16); // 完整的执勤时间位
+        }
+        return record;
     }
     // 读取文件函数
-    static void loadFromFile(Flag_group& flagGroup, const QString& filename) {
+    // 记录每名队员的记录位置，保存时可以只覆盖修改过的记录
+    // 只读取排班需要的信息（姓名、性别、组别、专业班级、执勤信息），档案信息只记录所在行的位置，第一次展示或修改队员时再读取
+    // lazyProfiles为false时档案信息也一并读出，供数据文件随时会被其他程序改写的花名册服务使用
+    static void loadFromFile(Flag_group& flagGroup, const QString& filename, bool lazyProfiles = true) {
         // 参数：Flag_group容器，QString文件名
+        qint64 fileSize = loadInBatches(filename, [&flagGroup](int groupNumber, std::vector<Person>& persons) {
+            flagGroup.addPersonsToGroup(std::move(persons), groupNumber);
+        }, std::numeric_limits<size_t>::max(), lazyProfiles);
+        if (fileSize >= 0) {
+            flagGroup.markSaved(fileSize); // 刚读取的花名册与文件一致
+        }
+    }
+    // 分批读取文件，同一组每读出batchSize名队员就交给onBatch一次（组别，该批队员），文件读完后交出各组剩余的队员
+    // 返回文件大小，无法打开文件时返回-1。不访问Flag_group，可在后台线程中调用，窗口启动时边读取边显示
+    // onBatch可以取走（移动）该批队员；本次读取的队员数据都从同一个内存池中分配
+    // 没有编号（旧版数据文件）或编号重复的队员在文件读完、已知最大编号后才分配编号，不会与后面读到的编号重复；
+    // 读到这样的队员后，之后的队员都留到文件读完再按原顺序交出
+    static qint64 loadInBatches(const QString& filename, const std::function<void(int, std::vector<Person>&)>& onBatch,
+                                size_t batchSize = 256, bool lazyProfiles = true) {
+        recoverJournal(filename); // 上次原位覆盖中途中断时先补完
         QFile file(filename);
-        if (file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            QTextStream in(&file);// 打开数据文件，准备读取
-            while (!in.atEnd()) {// 判断文件读取是否结束
-                QString line = in.readLine();// 读取一行文件数据
-                QStringList parts = line.split("|"); // 选定的数据分隔号
-                if (parts.size() == 10 + 20 + 3) {// 判定是否是正确的Person数据类型，如果是空行/其他错误数据，将不进行读取保存。
-                    std::string name = parts[0].toStdString(); // 姓名
-                    bool gender = parts[1].toInt(); // 性别
-                    int group = parts[2].toInt(); // 所属组别
-                    std::string phone_number = parts[3].toStdString(); // 联系电话
-                    std::string native_place = parts[4].toStdString(); // 籍贯
-                    std::string native = parts[5].toStdString(); // 民族
-                    std::string dorm = parts[6].toStdString(); // 寝室号
-                    std::string school = parts[7].toStdString(); // 学院
-                    std::string classname = parts[8].toStdString(); // 专业班级
-                    std::string birthday = parts[9].toStdString(); // 生日
-                    bool isWork = parts[10].toInt(); // 是否参与排班
-                    bool time[4][5];
-                    for (int i = 0; i < 4; ++i) {
-                        for (int j = 0; j < 5; ++j) {
-                            time[i][j] = parts[11 + i * 5 + j].toInt(); // 时间安排表
-                        }
-                    }
-                    int times = parts[31].toInt(); // 本次执勤次数
-                    int all_times = parts[32].toInt(); // 总执勤次数
-                    Person person(name, gender, group, phone_number, native_place, native, dorm, school, classname, birthday, isWork, time, times, all_times);
-                    flagGroup.addPersonToGroup(person, group);
+        if (!file.open(QIODevice::ReadOnly)) { // 以二进制方式读取，保证记录的行首位置与文件字节位置一致
+            // 测试代码
+            // qDebug() << "无法打开文件 " << filename << " 进行读取！";
+            return -1;
+        }
+        auto profileSource = lazyProfiles ? FileProfileSource::create(filename) : nullptr;
+        auto arena = std::make_shared<PersonArena>();
+        std::unordered_set<int> ids; // 已读出的队员编号
+        int maxId = 0; // 已读出的最大队员编号
+        bool holdBatches = false; // 是否已读到需要分配编号的队员
+        std::vector<Person> pending[4]; // 各组尚未交出的队员
+        qint64 offset = 0; // 当前行的行首位置
+        while (!file.atEnd()) {// 判断文件读取是否结束
+            QByteArray bytes = file.readLine();// 读取一行文件数据
+            qint64 lineOffset = offset;
+            offset += bytes.size();
+            while (bytes.endsWith('\n') || bytes.endsWith('\r')) {
+                bytes.chop(1);
+            }
+            QString line = QString::fromUtf8(bytes);
+            Person person;
+            if (parseLine(line, person, profileSource, lineOffset, arena)) {// 判定是否是正确的Person数据类型，如果是空行/其他错误数据，将不进行读取保存。
+                person.markSaved(lineOffset, static_cast<int>(bytes.size()));
+                if (person.getId() > 0 && !ids.insert(person.getId()).second) {
+                    person.setId(0); // 文件被手工改动出现重复编号时，后出现的队员重新分配编号
+                }
+                maxId = std::max(maxId, person.getId());
+                holdBatches = holdBatches || person.getId() == 0;
+                int groupNumber = person.getGroup();
+                std::vector<Person>& batch = pending[groupNumber - 1];
+                batch.push_back(std::move(person));
+                if (!holdBatches && batch.size() >= batchSize) {
+                    onBatch(groupNumber, batch);
+                    batch.clear();
                 }
             }
-            file.close();// 关闭文件
         }
-        // 测试代码
-        // else {
-        //     qDebug() << "无法打开文件 " << filename << " 进行读取！";
-        // }
+        file.close();// 关闭文件
+        int nextId = maxId + 1; // 比文件中全部编号都大，分配的编号互不重复
+        for (auto& batch : pending) {
+            for (Person& person : batch) {
+                if (person.getId() == 0) {
+                    person.setId(nextId++);
+                }
+            }
+        }
+        for (int i = 0; i < 4; ++i) {
+            if (!pending[i].empty()) {
+                onBatch(i + 1, pending[i]);
+            }
+        }
+        return offset;
+    }
+    // 解析一行队员数据
+    // 参数：QString line：数据文件中的一行。Person person：解析成功时写入的队员
+    // profileSource/offset：给出时档案信息不解析，改为记录其来源与行首位置，第一次用到时再读取
+    // arena：给出时队员数据从该内存池中分配
+    // 返回值：该行是否为完整、合法的队员数据。字段数不对、数字字段无法解析、组别不在1~4、
+    // 标记位不是0/1、执勤次数为负数时都视为错误数据，整行丢弃，不会产生半截队员
+    // 第34个字段为队员编号；旧版数据文件没有这一字段，读出的队员编号为0，加入花名册时分配，下次保存时写入
+    // 第35个字段为完整的执勤时间位，只在4行 × 5列以外也有空时写出，须与前面的执勤时间表一致
+    static bool parseLine(const QString& line, Person& person,
+                          const std::shared_ptr<const ProfileSource>& profileSource = nullptr, qint64 offset = 0,
+                          const std::shared_ptr<PersonArena>& arena = nullptr) {
+        const auto parts = QStringView(line).split(u'|'); // 选定的数据分隔号，按视图切分，不为每个字段复制字符串
+        if (parts.size() < 10 + 20 + 3 || parts.size() > 10 + 20 + 5) {
+            return false;
+        }
+        bool ok = true;
+        // 读取取值只能为0或1的标记位
+        auto readFlag = [&ok](QStringView text) {
+            bool fieldOk = false;
+            int value = text.toInt(&fieldOk);
+            ok = ok && fieldOk && (value == 0 || value == 1);
+            return value == 1;
+        };
+        // 读取非负整数
+        auto readCount = [&ok](QStringView text) {
+            bool fieldOk = false;
+            int value = text.toInt(&fieldOk);
+            ok = ok && fieldOk && value >= 0;
+            return value;
+        };
+        std::string name = parts[0].toString().toStdString(); // 姓名
+        bool gender = readFlag(parts[1]); // 性别
+        int group = readCount(parts[2]); // 所属组别
+        std::string classname = parts[8].toString().toStdString(); // 专业班级
+        bool isWork = readFlag(parts[10]); // 是否参与排班
+        bool time[Person::maxTimeRows][Person::maxDays] = {};
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 5; ++j) {
+                time[i][j] = readFlag(parts[11 + i * 5 + j]); // 时间安排表
+            }
+        }
+        int times = readCount(parts[31]); // 本次执勤次数
+        int all_times = readCount(parts[32]); // 总执勤次数
+        int id = parts.size() > 33 ? readCount(parts[33]) : 0; // 队员编号
+        quint64 timeBits = 0; // 完整的执勤时间位，没有这一字段时为0
+        if (parts.size() > 34) {
+            bool fieldOk = false;
+            timeBits = parts[34].toULongLong(&fieldOk, 16);
+            // 必须有20格以外的执勤时间，不超出执勤时间表的容量，且20格以内与前面的字段一致
+            quint64 capacity = (quint64(1) << (Person::maxTimeRows * Person::maxDays)) - 1;
+            quint64 legacy = 0;
+            for (int i = 0; i < 4; ++i) {
+                for (int j = 0; j < 5; ++j) {
+                    legacy |= quint64(time[i][j]) << (i * Person::maxDays + j);
+                }
+            }
+            ok = ok && fieldOk && (timeBits & ~legacyTimeBits()) && !(timeBits & ~capacity) && (timeBits & legacyTimeBits()) == legacy;
+        }
+        if (!ok || group < 1 || group > 4) {
+            return false;
+        }
+        if (profileSource) {
+            // 档案信息延迟读取
+            person = Person(name, gender, group, classname, isWork, time, times, all_times, profileSource, offset, arena);
+        } else {
+            std::string phone_number = parts[3].toString().toStdString(); // 联系电话
+            std::string native_place = parts[4].toString().toStdString(); // 籍贯
+            std::string native = parts[5].toString().toStdString(); // 民族
+            std::string dorm = parts[6].toString().toStdString(); // 寝室号
+            std::string school = parts[7].toString().toStdString(); // 学院
+            std::string birthday = parts[9].toString().toStdString(); // 生日
+            person = Person(name, gender, group, phone_number, native_place, native, dorm, school, classname, birthday, isWork, time, times, all_times, arena);
+        }
+        if (timeBits) {
+            person.setTimeBits(timeBits);
+        }
+        person.setId(id);
+        return true;
+    }
+    // 数据文件中以0/1字段写出的执勤时间位：第1~4行、第1~5列
+    static quint64 legacyTimeBits() {
+        quint64 bits = 0;
+        for (int row = 0; row < 4; ++row) {
+            bits |= quint64(0x1F) << (row * Person::maxDays);
+        }
+        return bits;
     }
 };
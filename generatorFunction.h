@@ -0,0 +1,143 @@
+// generatorFunction.h头文件
+// 功能说明：模拟花名册生成器RosterGenerator，用于排班与文件读写的压力测试
+// 按给定的人数、各组人数比例、执勤时间的有空比例生成队员，写出与主程序格式相同的data.txt，可直接由
+// FlagGroupFileManager::loadFromFile读取。队员逐条生成、逐块写出，内存占用与人数无关，可以生成数百万条记录
+//
+// 执勤时间的相关性：同一专业班级的队员课表相同，空闲时间大多一致。每个班级先生成一张班级空闲表，
+// 队员的每个执勤时间以correlation的概率照搬班级空闲表，否则独立抽取；两种方式的有空比例都是density，
+// 因此correlation只改变队员之间的相似程度，不改变总体的有空比例
+
+#pragma once
+
+#include <QSaveFile>
+#include <QByteArray>
+#include <array>
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+#include "Person.h"
+#include "fileFunction.h"
+
+// RosterGenerator 类定义，模拟花名册生成器
+class RosterGenerator
+{
+public:
+    // 生成参数
+    struct Options {
+        qint64 members = 1000; // 队员人数
+        std::array<double, 4> groupWeights = {1, 1, 1, 1}; // 一至四组的人数比例
+        double density = 0.4; // 每个执勤时间有空的比例，0~1
+        double correlation = 0.7; // 同班队员执勤时间照搬班级空闲表的比例，0为完全独立，1为同班完全相同
+        int classSize = 30; // 每个专业班级的人数
+        double workRatio = 1.0; // 参加排班的队员比例
+        quint64 seed = 0; // 随机数种子，相同的参数与种子生成相同的花名册
+    };
+
+    // 生成花名册并写入文件，返回写入的队员数，无法写入时返回-1
+    // 写入临时文件，全部写完后才替换原文件，中途失败不会留下半截的数据文件
+    static qint64 generate(const QString& filename, const Options& options) {
+        QSaveFile file(filename);
+        if (!file.open(QIODevice::WriteOnly)) {
+            return -1;
+        }
+        RosterGenerator generator(options);
+        QByteArray buffer;
+        const int flushSize = 1 << 20; // 缓冲区超过1MB时写出一次
+        buffer.reserve(flushSize + 256);
+        for (qint64 index = 0; index < options.members; ++index) {
+            buffer += FlagGroupFileManager::recordOf(generator.next(static_cast<int>(index + 1)));
+            buffer += '\n';
+            if (buffer.size() >= flushSize) {
+                if (file.write(buffer) != buffer.size()) {
+                    return -1;
+                }
+                buffer.clear();
+            }
+        }
+        if (file.write(buffer) != buffer.size()) {
+            return -1;
+        }
+        return file.commit() ? options.members : -1;
+    }
+
+private:
+    Options options; // 生成参数
+    std::mt19937_64 random; // 随机数引擎
+    std::discrete_distribution<int> groupDistribution; // 组别分布
+    bool classFree[4][5]; // 当前班级的空闲表
+    std::string classname; // 当前班级名称
+    int classMembers = 0; // 当前班级已生成的人数
+
+    explicit RosterGenerator(const Options& options) : options(options), random(options.seed) {
+        std::array<double, 4> weights = options.groupWeights;
+        for (double& weight : weights) {
+            weight = std::max(0.0, weight); // 负数比例按0处理，discrete_distribution要求非负
+        }
+        if (std::all_of(weights.begin(), weights.end(), [](double weight) { return weight <= 0; })) {
+            weights.fill(1); // 比例全为0时四个组平均分配
+        }
+        groupDistribution = std::discrete_distribution<int>(weights.begin(), weights.end());
+    }
+
+    double uniform() { return std::uniform_real_distribution<double>(0.0, 1.0)(random); }
+    template <size_t N>
+    const char* pick(const char* const (&items)[N]) { return items[std::uniform_int_distribution<size_t>(0, N - 1)(random)]; }
+    int between(int low, int high) { return std::uniform_int_distribution<int>(low, high)(random); }
+
+    // 换一个新班级：生成班级名称与班级空闲表
+    void nextClass() {
+        static const char* const majors[] = {"计算机", "软件", "通信", "自动化", "机械", "材料", "土木", "交通", "船舶", "能源",
+                                             "化学", "物理", "数学", "英语", "法学", "金融", "会计", "管理", "设计", "建筑"};
+        classname = std::string(pick(majors)) + std::to_string(between(20, 25) * 100 + between(1, 12));
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 5; ++j) {
+                classFree[i][j] = uniform() < options.density;
+            }
+        }
+        classMembers = 0;
+    }
+    // 生成一名队员，id：队员编号
+    Person next(int id) {
+        static const char* const surnames[] = {"王", "李", "张", "刘", "陈", "杨", "黄", "赵", "吴", "周", "徐", "孙", "马", "朱",
+                                               "胡", "郭", "何", "高", "林", "罗", "郑", "梁", "谢", "宋", "唐", "许", "韩", "冯"};
+        static const char* const givenNames[] = {"伟", "芳", "娜", "敏", "静", "强", "磊", "洋", "艳", "勇", "军", "杰", "娟", "涛",
+                                                 "明", "超", "秀", "霞", "平", "刚", "桂", "华", "文", "浩", "宇", "欣", "怡", "晨"};
+        static const char* const provinces[] = {"湖北", "湖南", "河南", "河北", "山东", "山西", "江西", "江苏", "浙江", "安徽",
+                                                "广东", "广西", "四川", "重庆", "贵州", "云南", "陕西", "甘肃", "福建", "辽宁"};
+        static const char* const nations[] = {"汉族", "汉族", "汉族", "汉族", "汉族", "汉族", "汉族", "汉族", "汉族", "土家族",
+                                              "回族", "苗族", "壮族", "满族", "蒙古族", "彝族"};
+        static const char* const schools[] = {"计算机与人工智能学院", "信息工程学院", "机电工程学院", "材料科学与工程学院",
+                                              "土木工程与建筑学院", "交通与物流工程学院", "船海与能源动力工程学院", "化学化工与生命科学学院",
+                                              "理学院", "外国语学院", "法学与人文社会学院", "经济学院", "管理学院", "艺术与设计学院"};
+        static const char* const dormAreas[] = {"东院", "西院", "南湖", "鉴湖", "余区", "马房山"};
+        if (classname.empty() || classMembers >= options.classSize) {
+            nextClass();
+        }
+        ++classMembers;
+        std::string name = std::string(pick(surnames)) + pick(givenNames);
+        if (uniform() < 0.6) {
+            name += pick(givenNames); // 六成队员为三字姓名
+        }
+        bool gender = uniform() < 0.5;
+        int group = groupDistribution(random) + 1;
+        std::string phone = "1" + std::to_string(between(3, 9)) + std::to_string(between(100000000, 999999999));
+        std::string nativePlace = pick(provinces);
+        std::string dorm = std::string(pick(dormAreas)) + std::to_string(between(1, 30)) + "-" + std::to_string(between(1, 6) * 100 + between(1, 30));
+        std::string birthday = std::to_string(between(2000, 2007)) + "-" + twoDigits(between(1, 12)) + "-" + twoDigits(between(1, 28));
+        bool isWork = uniform() < options.workRatio;
+        bool time[Person::maxTimeRows][Person::maxDays] = {}; // 只生成默认的4行 × 5列
+        for (int i = 0; i < 4; ++i) {
+            for (int j = 0; j < 5; ++j) {
+                time[i][j] = uniform() < options.correlation ? classFree[i][j] : uniform() < options.density;
+            }
+        }
+        Person person(name, gender, group, phone, nativePlace, pick(nations), dorm, pick(schools), classname, birthday,
+                      isWork, time, 0, between(0, 20));
+        person.setId(id);
+        return person;
+    }
+    static std::string twoDigits(int value) {
+        return (value < 10 ? "0" : "") + std::to_string(value);
+    }
+};
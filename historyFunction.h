@@ -0,0 +1,482 @@
+// historyFunction.h头文件
+// 功能说明：保存历次排班结果的执勤历史ScheduleHistory，用于跨学期核对执勤是否公平
+// 每周的工作表格压缩为各岗位的队员编号（默认60个：10个时间段 * 2个地点 * 3个岗位），追加写入历史文件；
+// 同一周重新排班或撤销排班时整体重写历史文件，文件中每周只保留一条记录，不会随重复制表无限增长
+// 内存中为每名队员维护按周排序的执勤记录与累计次数，以下查询都无需逐周扫描全部历史：
+// 某队员最近一次执勤的日期、某时间段某地点在一段日期内由谁执勤、一段日期内每名队员的执勤次数
+// 岗位与日期、时间段、地点的对应关系由执勤地点与仪式登记表决定，每条周记录带有保存时的工作日数、仪式数与地点数。
+// 修改配置前保存的周记录仍保留在文件中并计入按周统计的执勤次数，需要知道岗位对应日期的查询跳过这些周
+
+#pragma once
+
+#include <QDate>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QStringList>
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <algorithm>
+#include "Person.h"
+#include "dataFunction.h"
+#include "siteFunction.h"
+
+// ScheduleHistory 类定义，执勤历史
+class ScheduleHistory
+{
+public:
+    // 历史中的一名队员，以队员编号识别（与Flag_group的判定规则一致），改名后仍是同一名队员
+    // 旧版历史文件只记录了姓名+性别+专业班级，这样的队员在下次执勤时按这三项找到并补记编号
+    struct Member {
+        std::string name; // 姓名（最近一次执勤时的姓名）
+        bool gender; // 性别
+        std::string classname; // 专业班级
+        int id = 0; // 队员编号，旧版历史文件中没有，为0
+    };
+    // 保存一周排班结果带来的变化，用于撤销、重做该次排班
+    struct WeekChange {
+        QDate monday; // 该周周一
+        bool hadPrevious = false; // 保存前是否已有该周的记录
+        std::vector<int> previous; // 保存前该周的记录
+        QString previousLayout; // 保存前该周记录的岗位布局
+        std::vector<int> seats; // 保存的记录
+        QString layout; // 保存的记录的岗位布局
+    };
+    // 一次执勤记录
+    struct Duty {
+        QDate date; // 执勤日期
+        int slot; // 时间段，默认0~9
+        int location; // 地点，默认0：南鉴湖，1：东西院
+    };
+
+    // 构造函数
+    // 参数：QString filename：历史文件名。registry：执勤地点与仪式登记表，决定岗位对应的日期、时间段与地点，须比历史对象存在得更久
+    explicit ScheduleHistory(const QString& filename, const SiteRegistry& registry = SiteRegistry::defaults())
+        : filename(filename), registry(registry) {}
+
+    // 按当前登记表一周的岗位数，岗位编号与ScheduleTable::index一致
+    int seatsPerWeek() const { return registry.slotCount() * registry.siteCount() * ScheduleTable::peoplePerLocation; }
+    // 当前登记表的岗位布局：“工作日数,仪式数,地点数”
+    QString layout() const { return QString("%1,%2,%3").arg(registry.dayCount()).arg(registry.ceremonyCount()).arg(registry.siteCount()); }
+
+    // 读取历史文件，建立索引
+    void load() {
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return; // 还没有历史文件
+        }
+        QTextStream in(&file);
+        int memberRecords = 0; // 文件中的队员行数
+        int weekRecords = 0; // 文件中有效的周记录行数
+        while (!in.atEnd()) {
+            QStringList parts = in.readLine().split("|");
+            if ((parts.size() == 5 || parts.size() == 6) && parts[0] == "M") {
+                // 队员行：M|编号|姓名|性别|专业班级|队员编号，旧版没有队员编号
+                // 编号已出现过时为改名或补记队员编号，以最后一行为准
+                int index = parts[1].toInt();
+                Member member{parts[2].toStdString(), parts[3] == "1", parts[4].toStdString(), parts.size() == 6 ? parts[5].toInt() : 0};
+                if (index == static_cast<int>(members.size())) {
+                    addMember(member);
+                } else if (index >= 0 && index < static_cast<int>(members.size())) {
+                    updateMember(index, member);
+                }
+                ++memberRecords;
+            } else if ((parts.size() == 3 || parts.size() == 4) && parts[0] == "W") {
+                // 周记录行：W|周一日期|各岗位的队员编号（-1表示空岗）|岗位布局，默认布局不写，旧版文件也没有
+                // 布局与当前登记表不同的周同样读入
+                QDate monday = QDate::fromString(parts[1], Qt::ISODate);
+                QStringList ids = parts[2].split(",");
+                QString weekLayout = parts.size() == 4 ? parts[3] : defaultLayout;
+                if (!monday.isValid() || ids.size() != layoutSeats(weekLayout)) {
+                    continue;
+                }
+                std::vector<int> seats(ids.size());
+                bool ok = true;
+                for (int seat = 0; seat < ids.size(); ++seat) {
+                    seats[seat] = ids[seat].toInt(&ok);
+                    ok = ok && seats[seat] >= -1 && seats[seat] < static_cast<int>(members.size());
+                    if (!ok) {
+                        break;
+                    }
+                }
+                if (ok) {
+                    storeWeek(monday, seats, weekLayout);
+                    ++weekRecords;
+                }
+            }
+        }
+        file.close();
+        rebuildIndex();
+        if (memberRecords > static_cast<int>(members.size()) || weekRecords > static_cast<int>(weeks.size())) {
+            rewrite(); // 旧版本程序追加的重复周记录、改名记录，整理为每周、每名队员一条
+        }
+    }
+
+    // 保存一周的排班结果，返回带来的变化，交给撤销栈以便撤销该次排班时一并撤销
+    // 参数：QDate monday：该周周一的日期。scheduleTable：排班得到的工作表格
+    // 同一周重复保存时，以最后一次为准：新的一周追加写入文件，覆盖已有的一周时整体重写文件
+    WeekChange commitWeek(const QDate& monday, const ScheduleTable& scheduleTable) {
+        WeekChange change;
+        change.monday = monday;
+        int existing = firstWeekOnOrAfter(monday);
+        if (existing < static_cast<int>(weeks.size()) && weeks[existing].monday == monday) {
+            change.hadPrevious = true;
+            change.previous = weeks[existing].seats;
+            change.previousLayout = weeks[existing].layout;
+        }
+        SeatView allSeats = scheduleTable.allSeats();
+        std::vector<int> seats(allSeats.size(), -1);
+        QString newMembers;
+        for (int seat = 0; seat < allSeats.size(); ++seat) {
+            const Person* person = allSeats[seat];
+            if (person) {
+                bool changed = false;
+                int index = internMember(*person, changed);
+                if (changed) {
+                    // 新队员，或队员改名、补记队员编号
+                    newMembers += QString("M|%1|%2|%3|%4|%5\n").arg(index).arg(QString::fromStdString(person->getName()))
+                                      .arg(person->getGender() ? "1" : "0").arg(QString::fromStdString(person->getClassname()))
+                                      .arg(person->getId());
+                }
+                seats[seat] = index;
+            }
+        }
+        change.seats = seats;
+        change.layout = layout();
+        bool appended = storeWeek(monday, seats, change.layout);
+        if (appended) {
+            indexWeek(static_cast<int>(weeks.size()) - 1); // 新的一周排在最后，增量更新索引
+        } else {
+            rebuildIndex(); // 覆盖旧的一周或插入较早的一周，重建索引
+        }
+        if (change.hadPrevious) {
+            rewrite(); // 覆盖已有的一周，整体重写，不在文件中留下被覆盖的记录
+            return change;
+        }
+        // 追加写入历史文件
+        QFile file(filename);
+        if (file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) {
+            QTextStream out(&file);
+            out << newMembers << weekLine(Week{monday, seats, change.layout});
+            file.close();
+        }
+        return change;
+    }
+    // 撤销一次保存：恢复保存前该周的记录，保存前没有该周时删除该周
+    void undoWeek(const WeekChange& change) {
+        setWeek(change.monday, change.hadPrevious ? &change.previous : nullptr, change.previousLayout);
+    }
+    // 重做一次保存
+    void redoWeek(const WeekChange& change) {
+        setWeek(change.monday, &change.seats, change.layout);
+    }
+
+    // 查询某队员最近一次执勤，从未执勤时返回false
+    bool lastDuty(const Person& person, Duty& duty) const {
+        int member = findMember(person);
+        if (member < 0) {
+            return false;
+        }
+        const std::vector<int>& served = memberWeeks[member];
+        for (auto it = served.rbegin(); it != served.rend(); ++it) { // 从最近一周往前找，跳过岗位数与当前登记表不同的周
+            const Week& week = weeks[*it];
+            if (!matchesLayout(week)) {
+                continue;
+            }
+            for (int seat = seatsPerWeek() - 1; seat >= 0; --seat) { // 从一周最后一个岗位往前找
+                if (week.seats[seat] == member) {
+                    duty = {seatDate(week, seat), seatSlot(seat), seatLocation(seat)};
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+    // 查询某队员在[from, to]日期内的执勤次数，借助累计次数二分查找，与历史周数的对数成正比
+    int dutyCount(const Person& person, const QDate& from, const QDate& to) const {
+        int member = findMember(person);
+        return member < 0 ? 0 : countInRange(member, from, to);
+    }
+    // 查询[from, to]日期内全部队员的执勤次数，返回（队员，次数），不含次数为0的队员
+    std::vector<std::pair<Member, int>> dutyCounts(const QDate& from, const QDate& to) const {
+        std::vector<std::pair<Member, int>> result;
+        for (int member = 0; member < static_cast<int>(members.size()); ++member) {
+            int count = countInRange(member, from, to);
+            if (count > 0) {
+                result.push_back({members[member], count});
+            }
+        }
+        return result;
+    }
+    // 查询[from, to]日期内某地点升旗（halfDay=0）或降旗（halfDay=1）由谁执勤，返回（队员，次数）
+    // 只访问日期范围内的周记录，每周只读取对应的岗位（默认15个）
+    std::vector<std::pair<Member, int>> whoServed(int location, int halfDay, const QDate& from, const QDate& to) const {
+        std::unordered_map<int, int> counts;
+        for (int w = firstWeekOnOrAfter(from.addDays(-lastDayOffset())); w < static_cast<int>(weeks.size()) && weeks[w].monday <= to; ++w) {
+            if (!matchesLayout(weeks[w])) {
+                continue;
+            }
+            for (int day = 0; day < registry.dayCount(); ++day) {
+                QDate date = weeks[w].monday.addDays(day);
+                if (date < from || date > to) {
+                    continue;
+                }
+                int slot = day * registry.ceremonyCount() + halfDay;
+                for (int position = 0; position < ScheduleTable::peoplePerLocation; ++position) {
+                    int member = weeks[w].seats[seatIndex(slot, location, position)];
+                    if (member >= 0) {
+                        counts[member]++;
+                    }
+                }
+            }
+        }
+        std::vector<std::pair<Member, int>> result;
+        for (const auto& entry : counts) {
+            result.push_back({members[entry.first], entry.second});
+        }
+        return result;
+    }
+
+    // 依次访问[from, to]日期范围内有执勤日的周记录，按日期升序调用visit(该周周一, 各岗位的历史队员编号，-1为空岗)
+    // 只访问岗位数与当前登记表一致的周，岗位编号与ScheduleTable::index一致
+    template <class Visit>
+    void forEachWeek(const QDate& from, const QDate& to, Visit visit) const {
+        for (int w = firstWeekOnOrAfter(from.addDays(-lastDayOffset())); w < static_cast<int>(weeks.size()) && weeks[w].monday <= to; ++w) {
+            if (matchesLayout(weeks[w])) {
+                visit(weeks[w].monday, weeks[w].seats);
+            }
+        }
+    }
+    // 历史队员编号对应的队员
+    const Member& member(int index) const { return members[index]; }
+
+private:
+    // 一周的排班记录
+    struct Week {
+        QDate monday; // 该周周一
+        std::vector<int> seats; // 每个岗位的队员编号，-1表示空岗
+        QString layout; // 保存时的岗位布局：“工作日数,仪式数,地点数”
+    };
+    // 某队员在某一周的执勤情况，用于累计次数的二分查找
+    struct MemberWeek {
+        int week; // 周记录下标
+        int cumulative; // 截至该周（含）的累计执勤次数
+    };
+
+    QString filename; // 历史文件名
+    const SiteRegistry& registry; // 执勤地点与仪式登记表
+    std::vector<Member> members; // 历史中出现过的全部队员，下标即队员编号
+    std::unordered_map<int, int> memberById; // 队员编号 -> 历史中的编号
+    std::unordered_map<std::string, int> legacyIndex; // 旧版历史中没有队员编号的队员：识别键 -> 历史中的编号
+    std::vector<Week> weeks; // 按日期升序排列的周记录
+    std::vector<std::vector<int>> memberWeeks; // 每名队员执勤过的周记录下标（升序）
+    std::vector<std::vector<MemberWeek>> memberCumulative; // 每名队员按周的累计执勤次数
+
+    int seatIndex(int slot, int location, int position) const {
+        return (slot * registry.siteCount() + location) * ScheduleTable::peoplePerLocation + position;
+    }
+    int seatSlot(int seat) const { return seat / ScheduleTable::peoplePerLocation / registry.siteCount(); }
+    int seatLocation(int seat) const { return seat / ScheduleTable::peoplePerLocation % registry.siteCount(); }
+    QDate seatDate(const Week& week, int seat) const { return week.monday.addDays(registry.slotDay(seatSlot(seat)) - 1); }
+    // 一周最后一个工作日与周一相差的天数，默认4（周五）
+    int lastDayOffset() const { return registry.dayCount() - 1; }
+    // 周记录的岗位布局与当前登记表一致，岗位才能换算为日期、时间段与地点
+    bool matchesLayout(const Week& week) const { return week.layout == layout(); }
+
+    static constexpr const char* defaultLayout = "5,2,2"; // 默认登记表的岗位布局，周记录行中省略
+    // 岗位布局对应的一周岗位数，布局无效时返回-1
+    static int layoutSeats(const QString& layout) {
+        QStringList counts = layout.split(",");
+        if (counts.size() != 3) {
+            return -1;
+        }
+        int seats = ScheduleTable::peoplePerLocation;
+        for (const QString& count : counts) {
+            bool ok = false;
+            int value = count.toInt(&ok);
+            if (!ok || value <= 0 || value > SiteRegistry::maxCrews) {
+                return -1;
+            }
+            seats *= value;
+        }
+        return seats;
+    }
+    // 周记录行，默认布局时不写布局字段，与旧版文件相同
+    static QString weekLine(const Week& week) {
+        QStringList ids;
+        for (int id : week.seats) {
+            ids << QString::number(id);
+        }
+        QString line = "W|" + week.monday.toString(Qt::ISODate) + "|" + ids.join(",");
+        if (week.layout != defaultLayout) {
+            line += "|" + week.layout;
+        }
+        return line + "\n";
+    }
+    static std::string memberKey(const std::string& name, bool gender, const std::string& classname) {
+        return name + '\x1f' + (gender ? '1' : '0') + '\x1f' + classname;
+    }
+    void addMember(const Member& member) {
+        members.push_back(member);
+        memberWeeks.emplace_back();
+        memberCumulative.emplace_back();
+        indexMember(static_cast<int>(members.size()) - 1);
+    }
+    // 更新队员的姓名等信息或补记队员编号
+    void updateMember(int index, const Member& member) {
+        const Member& old = members[index];
+        if (old.id > 0) {
+            memberById.erase(old.id);
+        } else {
+            legacyIndex.erase(memberKey(old.name, old.gender, old.classname));
+        }
+        members[index] = member;
+        indexMember(index);
+    }
+    void indexMember(int index) {
+        const Member& member = members[index];
+        if (member.id > 0) {
+            memberById[member.id] = index;
+        } else {
+            legacyIndex[memberKey(member.name, member.gender, member.classname)] = index;
+        }
+    }
+    // 返回队员在历史中的编号，第一次出现时加入；changed：是否新加入或更新了队员信息，需要写入队员行
+    int internMember(const Person& person, bool& changed) {
+        Member member{person.getName(), person.getGender(), person.getClassname(), person.getId()};
+        int index = findMember(person);
+        if (index < 0) {
+            index = static_cast<int>(members.size());
+            addMember(member);
+            changed = true;
+        } else if (members[index].id != member.id || members[index].name != member.name
+                   || members[index].gender != member.gender || members[index].classname != member.classname) {
+            updateMember(index, member);
+            changed = true;
+        }
+        return index;
+    }
+    // 先按队员编号查找，找不到时再在旧版历史的队员中按姓名+性别+专业班级查找
+    int findMember(const Person& person) const {
+        auto it = memberById.find(person.getId());
+        if (it != memberById.end()) {
+            return it->second;
+        }
+        auto legacy = legacyIndex.find(memberKey(person.getName(), person.getGender(), person.getClassname()));
+        return legacy == legacyIndex.end() ? -1 : legacy->second;
+    }
+    int firstWeekOnOrAfter(const QDate& date) const {
+        auto it = std::lower_bound(weeks.begin(), weeks.end(), date, [](const Week& week, const QDate& value) {
+            return week.monday < value;
+        });
+        return static_cast<int>(it - weeks.begin());
+    }
+    // 把某一周设为给定的记录（seats为空时删除该周），重建索引并整体重写文件
+    void setWeek(const QDate& monday, const std::vector<int>* seats, const QString& weekLayout) {
+        if (seats) {
+            storeWeek(monday, *seats, weekLayout);
+        } else {
+            int position = firstWeekOnOrAfter(monday);
+            if (position < static_cast<int>(weeks.size()) && weeks[position].monday == monday) {
+                weeks.erase(weeks.begin() + position);
+            }
+        }
+        rebuildIndex();
+        rewrite();
+    }
+    // 整体重写历史文件：每名队员一行（最新的信息），每周一行，按日期升序
+    // 先写入临时文件，写完后替换原文件，中途失败时原文件不变
+    void rewrite() const {
+        QSaveFile file(filename);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Text)) {
+            return;
+        }
+        QTextStream out(&file);
+        for (int index = 0; index < static_cast<int>(members.size()); ++index) {
+            const Member& member = members[index];
+            out << QString("M|%1|%2|%3|%4|%5\n").arg(index).arg(QString::fromStdString(member.name))
+                       .arg(member.gender ? "1" : "0").arg(QString::fromStdString(member.classname)).arg(member.id);
+        }
+        for (const Week& week : weeks) {
+            out << weekLine(week);
+        }
+        out.flush();
+        file.commit();
+    }
+    // 按日期有序地保存一周记录，返回是否追加在末尾
+    bool storeWeek(const QDate& monday, const std::vector<int>& seats, const QString& weekLayout) {
+        int position = firstWeekOnOrAfter(monday);
+        if (position < static_cast<int>(weeks.size()) && weeks[position].monday == monday) {
+            weeks[position].seats = seats; // 同一周重复保存，以最后一次为准
+            weeks[position].layout = weekLayout;
+            return false;
+        }
+        weeks.insert(weeks.begin() + position, Week{monday, seats, weekLayout});
+        return position == static_cast<int>(weeks.size()) - 1;
+    }
+    // 将一周记录加入各队员的索引，要求该周为最后一周
+    void indexWeek(int week) {
+        std::unordered_map<int, int> counts;
+        for (int member : weeks[week].seats) {
+            if (member >= 0) {
+                counts[member]++;
+            }
+        }
+        for (const auto& entry : counts) {
+            std::vector<MemberWeek>& cumulative = memberCumulative[entry.first];
+            int previous = cumulative.empty() ? 0 : cumulative.back().cumulative;
+            memberWeeks[entry.first].push_back(week);
+            cumulative.push_back({week, previous + entry.second});
+        }
+    }
+    void rebuildIndex() {
+        for (auto& list : memberWeeks) {
+            list.clear();
+        }
+        for (auto& list : memberCumulative) {
+            list.clear();
+        }
+        for (int week = 0; week < static_cast<int>(weeks.size()); ++week) {
+            indexWeek(week);
+        }
+    }
+    // 某队员在[from, to]日期内的执勤次数
+    // 周记录按周统计，范围两端不足一周的部分逐日核对；岗位数与当前登记表不同的周无法逐日核对，只按整周统计
+    int countInRange(int member, const QDate& from, const QDate& to) const {
+        const std::vector<MemberWeek>& cumulative = memberCumulative[member];
+        int firstFull = firstWeekOnOrAfter(from); // 周一不早于from的第一周
+        int endFull = firstWeekOnOrAfter(to.addDays(1 - lastDayOffset())); // 最后一个工作日晚于to的第一周
+        auto cumulativeBefore = [&cumulative](int week) {
+            auto it = std::lower_bound(cumulative.begin(), cumulative.end(), week, [](const MemberWeek& entry, int value) {
+                return entry.week < value;
+            });
+            return it == cumulative.begin() ? 0 : (it - 1)->cumulative;
+        };
+        int count = 0;
+        if (firstFull < endFull) {
+            count += cumulativeBefore(endFull) - cumulativeBefore(firstFull);
+        }
+        // 范围两端只被部分覆盖的周
+        auto countPartialWeek = [&](int week) {
+            if (week < 0 || week >= static_cast<int>(weeks.size()) || !matchesLayout(weeks[week])) {
+                return 0;
+            }
+            int partial = 0;
+            for (int seat = 0; seat < seatsPerWeek(); ++seat) {
+                if (weeks[week].seats[seat] == member && seatDate(weeks[week], seat) >= from && seatDate(weeks[week], seat) <= to) {
+                    partial++;
+                }
+            }
+            return partial;
+        };
+        int lastPartial = std::max(endFull, firstFull);
+        if (firstFull - 1 >= 0 && weeks[firstFull - 1].monday.addDays(lastDayOffset()) >= from) {
+            count += countPartialWeek(firstFull - 1);
+        }
+        if (lastPartial < static_cast<int>(weeks.size()) && weeks[lastPartial].monday <= to) {
+            count += countPartialWeek(lastPartial);
+        }
+        return count;
+    }
+};
@@ -0,0 +1,429 @@
+// importFunction.h头文件
+// 功能说明：从报名表（CSV/XLSX）批量导入新队员RosterImporter
+// 报名表第一行为表头，按列名把各列对应到队员的基础信息与执勤时间，列的顺序不限，缺少的列留空
+// 表头之后的各行按块分给线程池并行解析；解析完成后按报名表中的顺序去重：
+// 与花名册中已有队员、或与报名表中前面的行识别为同一人（姓名+性别+专业班级，与Flag_group的判定规则一致）时跳过
+
+#pragma once
+
+#include <QFile>
+#include <QFileInfo>
+#include <QDir>
+#include <QDateTime>
+#include <QStringDecoder>
+#include <QStringList>
+#include <QThread>
+#include <QVariant>
+#include <QAxObject>
+#include <QtConcurrent/QtConcurrent>
+#include <vector>
+#include <string>
+#include <unordered_set>
+#include <algorithm>
+#include "Person.h"
+#include "Flag_group.h"
+#include "siteFunction.h"
+
+// RosterImporter 类定义，报名表导入
+class RosterImporter
+{
+public:
+    // 导入结果
+    struct Result {
+        std::vector<Person> persons[4]; // 待加入一至四组的新队员，保持报名表中的顺序
+        int imported = 0; // 新队员人数
+        int duplicates = 0; // 与花名册或报名表前面的行重复而跳过的行数
+        int invalid = 0; // 缺少姓名而跳过的行数
+        QString error; // 文件无法读取或表头没有姓名列时的错误信息，为空表示读取成功
+    };
+
+    // 导入函数
+    // 参数：QString filePath：报名表文件，.csv或.xlsx。Flag_group：现有花名册，用于去重
+    // int defaultGroup：报名表没有组别列、或组别无法识别时新队员所在的组别（1~4）
+    // SiteRegistry：执勤地点与仪式登记表，执勤时间列按其中的星期、仪式、地点名称识别
+    // 新队员的执勤次数均为0、不参与排班；报名表中没有执勤时间列时，执勤时间全部为没空，与“添加组员”一致
+    static Result importFile(const QString& filePath, const Flag_group& flagGroup, int defaultGroup,
+                             const SiteRegistry& registry = SiteRegistry::defaults()) {
+        Result result;
+        std::vector<Parsed> parsed;
+        if (QFileInfo(filePath).suffix().compare("xlsx", Qt::CaseInsensitive) == 0) {
+            parsed = parseXlsx(filePath, defaultGroup, registry, result.error);
+        } else {
+            parsed = parseCsv(filePath, defaultGroup, registry, result.error);
+        }
+        if (!result.error.isEmpty()) {
+            return result;
+        }
+        // 去重：先放入花名册中全部队员的识别键，再按报名表顺序逐行检查
+        std::unordered_set<std::string> keys;
+        for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+            for (const auto& member : flagGroup.getGroupMembers(groupNumber)) {
+                keys.insert(memberKey(member));
+            }
+        }
+        for (const Parsed& chunk : parsed) {
+            result.invalid += chunk.invalid;
+            for (const Person& person : chunk.persons) {
+                if (!keys.insert(memberKey(person)).second) {
+                    result.duplicates++;
+                    continue;
+                }
+                result.persons[person.getGroup() - 1].push_back(person);
+                result.imported++;
+            }
+        }
+        return result;
+    }
+
+private:
+    // 一个执勤时间列对应的time数组位置
+    struct TimeColumn {
+        int column; // 列号
+        int row; // time数组的行，1：升旗南鉴湖，2：升旗东西院，3：降旗南鉴湖，4：降旗东西院
+        int day; // 星期，1~5
+    };
+    // 表头中各项信息所在的列，-1表示报名表没有该列
+    struct Columns {
+        int name = -1, gender = -1, group = -1, phone = -1, nativePlace = -1, native = -1;
+        int dorm = -1, school = -1, classname = -1, birthday = -1;
+        std::vector<TimeColumn> times;
+    };
+    // 一块数据行的解析结果
+    struct Parsed {
+        std::vector<Person> persons; // 解析出的队员，尚未去重
+        int invalid = 0; // 缺少姓名的行数
+        bool decodeError = false; // CSV按当前编码解码失败
+    };
+
+    static std::string memberKey(const Person& person) {
+        return person.getName() + '\x1f' + (person.getGender() ? '1' : '0') + '\x1f' + person.getClassname();
+    }
+
+    // 识别表头，返回各项信息所在的列
+    static Columns mapHeader(const QStringList& header, const SiteRegistry& registry) {
+        Columns columns;
+        // 在表头中查找登记表中的名称，返回下标，找不到时返回-1
+        auto findName = [](const QString& title, int count, auto nameOf) {
+            for (int i = 0; i < count; ++i) {
+                if (title.contains(nameOf(i))) {
+                    return i;
+                }
+            }
+            return -1;
+        };
+        for (int column = 0; column < header.size(); ++column) {
+            QString title = header[column].simplified().remove(' ');
+            int halfDay = findName(title, registry.ceremonyCount(), [&registry](int i) { return registry.ceremony(i).name; });
+            if (halfDay >= 0) {
+                // 执勤时间列，如“周一升旗南鉴湖”“星期一升旗南鉴湖”；没有写地点时所有地点都适用
+                int dayIndex = -1;
+                for (int i = 0; i < registry.dayCount() && dayIndex < 0; ++i) {
+                    if (registry.mentionsDay(title, i)) {
+                        dayIndex = i;
+                    }
+                }
+                if (dayIndex < 0) {
+                    continue;
+                }
+                int location = findName(title, registry.siteCount(), [&registry](int i) { return registry.site(i).name; });
+                for (int l = 0; l < registry.siteCount(); ++l) {
+                    if (location < 0 || location == l) {
+                        int slot = dayIndex * registry.ceremonyCount() + halfDay;
+                        columns.times.push_back({column, registry.timeRow(slot, l), registry.slotDay(slot)});
+                    }
+                }
+            } else if (title == "姓名" || title == "名字") {
+                columns.name = column;
+            } else if (title == "性别") {
+                columns.gender = column;
+            } else if (title == "组别" || title == "所属组别" || title == "组") {
+                columns.group = column;
+            } else if (title.contains("电话") || title.contains("手机")) {
+                columns.phone = column;
+            } else if (title == "籍贯") {
+                columns.nativePlace = column;
+            } else if (title == "民族") {
+                columns.native = column;
+            } else if (title.contains("寝室")) {
+                columns.dorm = column;
+            } else if (title == "学院") {
+                columns.school = column;
+            } else if (title.contains("班级") || title == "专业") {
+                columns.classname = column;
+            } else if (title == "生日" || title == "出生日期") {
+                columns.birthday = column;
+            }
+        }
+        return columns;
+    }
+
+    // 将一个数据行转换为队员，缺少姓名时返回false
+    // arena：队员数据的内存池，每个分块各用一个，分块内的队员不必逐个向堆申请内存
+    static bool mapRow(const QStringList& fields, const Columns& columns, int defaultGroup, Person& person,
+                       const std::shared_ptr<PersonArena>& arena) {
+        // 取出某列的文本。数据文件以“|”分隔字段、以换行分隔队员，simplified已将换行替换为空格，“|”替换为“/”
+        auto text = [&fields](int column) {
+            if (column < 0 || column >= fields.size()) {
+                return QString();
+            }
+            return fields[column].simplified().replace('|', '/');
+        };
+        auto field = [&text](int column) {
+            return text(column).toStdString();
+        };
+        std::string name = field(columns.name);
+        if (name.empty()) {
+            return false;
+        }
+        QString genderText = text(columns.gender);
+        bool gender = genderText == "女" || genderText.compare("F", Qt::CaseInsensitive) == 0
+                      || genderText.compare("female", Qt::CaseInsensitive) == 0;
+        int group = defaultGroup;
+        QString groupText = text(columns.group);
+        static const QString groupDigits = "1234";
+        static const QString groupNames = "一二三四";
+        for (int i = 0; i < 4; ++i) {
+            if (groupText.contains(groupDigits[i]) || groupText.contains(groupNames[i])) {
+                group = i + 1;
+                break;
+            }
+        }
+        bool time[Person::maxTimeRows][Person::maxDays] = {};
+        for (const TimeColumn& timeColumn : columns.times) {
+            if (isYes(text(timeColumn.column))) {
+                time[timeColumn.row - 1][timeColumn.day - 1] = true;
+            }
+        }
+        person = Person(name, gender, group, field(columns.phone), field(columns.nativePlace), field(columns.native),
+                        field(columns.dorm), field(columns.school), field(columns.classname), field(columns.birthday),
+                        false, time, 0, 0, arena);
+        return true;
+    }
+    // 执勤时间单元格是否表示有空
+    static bool isYes(const QString& text) {
+        static const QStringList yes = {"1", "是", "有", "有空", "可以", "√", "✓", "y", "yes", "true"};
+        return yes.contains(text, Qt::CaseInsensitive);
+    }
+    static bool isBlank(const QStringList& fields) {
+        return std::all_of(fields.begin(), fields.end(), [](const QString& text) { return text.trimmed().isEmpty(); });
+    }
+
+    // 每个线程分到的块数，块数多于线程数，各线程的负载更均匀
+    static int chunkCount() {
+        return std::max(1, QThread::idealThreadCount()) * 4;
+    }
+
+    // 读取CSV文件
+    // 先顺序扫描一遍字节，在引号之外的换行处把文件切成若干块，各块再并行解码、拆分字段、转换为队员
+    // 优先按UTF-8解码，有任何一块不是合法的UTF-8时改用系统编码（中文Windows下为GBK）整体重新解析
+    static std::vector<Parsed> parseCsv(const QString& filePath, int defaultGroup, const SiteRegistry& registry, QString& error) {
+        QFile file(filePath);
+        if (!file.open(QIODevice::ReadOnly)) {
+            error = "无法打开文件：" + filePath;
+            return {};
+        }
+        const QByteArray bytes = file.readAll();
+        file.close();
+        qsizetype start = bytes.startsWith("\xEF\xBB\xBF") ? 3 : 0; // 跳过UTF-8 BOM
+        // 切块：每块至少64KB，只在引号之外的换行处切开，保证一条记录不会被分到两块
+        // UTF-8与GBK的多字节字符中都不会出现引号和换行的字节值，按字节扫描是安全的
+        const qsizetype target = std::max<qsizetype>(64 * 1024, (bytes.size() - start) / chunkCount() + 1);
+        std::vector<std::pair<qsizetype, qsizetype>> ranges; // 每块的起止字节位置
+        bool inQuotes = false;
+        qsizetype chunkBegin = start;
+        for (qsizetype i = start; i < bytes.size(); ++i) {
+            char c = bytes[i];
+            if (c == '"') {
+                inQuotes = !inQuotes;
+            } else if (c == '\n' && !inQuotes && i + 1 - chunkBegin >= target) {
+                ranges.push_back({chunkBegin, i + 1});
+                chunkBegin = i + 1;
+            }
+        }
+        if (chunkBegin < bytes.size()) {
+            ranges.push_back({chunkBegin, bytes.size()});
+        }
+        if (ranges.empty()) {
+            error = "报名表为空";
+            return {};
+        }
+        // 第一块中的第一条记录为表头
+        for (auto encoding : {QStringDecoder::Utf8, QStringDecoder::System}) {
+            QStringDecoder decoder(encoding);
+            QString firstChunk = decoder(QByteArrayView(bytes).sliced(ranges[0].first, ranges[0].second - ranges[0].first));
+            if (decoder.hasError()) {
+                continue;
+            }
+            qsizetype headerEnd = 0;
+            const QStringList header = nextCsvRecord(firstChunk, headerEnd);
+            const Columns columns = mapHeader(header, registry);
+            if (columns.name < 0) {
+                error = "报名表第一行没有“姓名”列";
+                return {};
+            }
+            std::vector<Parsed> parsed(ranges.size());
+            std::vector<int> indexes(ranges.size());
+            for (size_t i = 0; i < indexes.size(); ++i) {
+                indexes[i] = static_cast<int>(i);
+            }
+            QtConcurrent::blockingMap(indexes, [&](int index) {
+                QStringDecoder chunkDecoder(encoding);
+                QString text = chunkDecoder(QByteArrayView(bytes).sliced(ranges[index].first, ranges[index].second - ranges[index].first));
+                Parsed& chunk = parsed[index];
+                if (chunkDecoder.hasError()) {
+                    chunk.decodeError = true;
+                    return;
+                }
+                qsizetype position = index == 0 ? headerEnd : 0; // 第一块跳过表头
+                auto arena = std::make_shared<PersonArena>();
+                while (position < text.size()) {
+                    const QStringList fields = nextCsvRecord(text, position);
+                    if (isBlank(fields)) {
+                        continue;
+                    }
+                    Person person;
+                    if (mapRow(fields, columns, defaultGroup, person, arena)) {
+                        chunk.persons.push_back(std::move(person));
+                    } else {
+                        chunk.invalid++;
+                    }
+                }
+            });
+            bool decodeError = std::any_of(parsed.begin(), parsed.end(), [](const Parsed& chunk) { return chunk.decodeError; });
+            if (!decodeError) {
+                return parsed;
+            }
+        }
+        error = "无法识别报名表的文字编码，请另存为UTF-8编码的CSV文件";
+        return {};
+    }
+    // 从position处读取一条CSV记录并拆分字段，position移到下一条记录的开头
+    // 支持用双引号包裹含逗号、换行的字段，字段内的两个双引号表示一个双引号
+    static QStringList nextCsvRecord(const QString& text, qsizetype& position) {
+        QStringList fields;
+        QString current;
+        bool inQuotes = false;
+        while (position < text.size()) {
+            QChar c = text[position++];
+            if (inQuotes) {
+                if (c == '"') {
+                    if (position < text.size() && text[position] == '"') {
+                        current += '"';
+                        ++position;
+                    } else {
+                        inQuotes = false;
+                    }
+                } else {
+                    current += c;
+                }
+            } else if (c == '"') {
+                inQuotes = true;
+            } else if (c == ',') {
+                fields << current;
+                current.clear();
+            } else if (c == '\n') {
+                break;
+            } else if (c != '\r') {
+                current += c;
+            }
+        }
+        fields << current;
+        return fields;
+    }
+
+    // 读取XLSX文件
+    // 通过Excel一次取出整张表已用区域的值（Excel只能在当前线程调用），再将各数据行分块并行转换为队员
+    static std::vector<Parsed> parseXlsx(const QString& filePath, int defaultGroup, const SiteRegistry& registry, QString& error) {
+        std::vector<QStringList> rows;
+        QAxObject* excel = new QAxObject("Excel.Application");
+        if (excel->isNull()) {
+            delete excel;
+            error = "无法启动 Excel 应用程序，请确保已安装 Excel，或将报名表另存为CSV文件。";
+            return {};
+        }
+        excel->setProperty("Visible", false);
+        excel->setProperty("DisplayAlerts", false);
+        QAxObject* workbooks = excel->querySubObject("Workbooks");
+        QAxObject* workbook = workbooks ? workbooks->querySubObject("Open(const QString&)", QDir::toNativeSeparators(filePath)) : nullptr;
+        bool sheetRead = false; // 是否读到了第一张工作表
+        if (workbook) {
+            // 工作簿没有工作表、或Excel无法给出已用区域时querySubObject返回空指针
+            QAxObject* worksheet = workbook->querySubObject("Worksheets(int)", 1);
+            QAxObject* usedRange = worksheet ? worksheet->querySubObject("UsedRange") : nullptr;
+            if (usedRange) {
+                sheetRead = true;
+                const QVariantList values = usedRange->property("Value").toList(); // 每个元素为一行
+                rows.reserve(values.size());
+                for (const QVariant& value : values) {
+                    QStringList fields;
+                    for (const QVariant& cell : value.toList()) {
+                        fields << cellText(cell);
+                    }
+                    rows.push_back(fields);
+                }
+            }
+            workbook->dynamicCall("Close(bool)", false); // 不保存，关闭工作簿
+        }
+        excel->dynamicCall("Quit()");
+        delete excel;
+        if (!workbook) {
+            error = "无法打开文件：" + filePath;
+            return {};
+        }
+        if (!sheetRead) {
+            error = "无法读取文件中的第一张工作表：" + filePath;
+            return {};
+        }
+        if (rows.empty()) {
+            error = "报名表为空";
+            return {};
+        }
+        const Columns columns = mapHeader(rows[0], registry);
+        if (columns.name < 0) {
+            error = "报名表第一行没有“姓名”列";
+            return {};
+        }
+        // 表头之后的数据行分块，每块至少256行
+        const int dataRows = static_cast<int>(rows.size()) - 1;
+        const int rowsPerChunk = std::max(256, dataRows / chunkCount() + 1);
+        std::vector<int> chunkBegins;
+        for (int begin = 1; begin <= dataRows; begin += rowsPerChunk) {
+            chunkBegins.push_back(begin);
+        }
+        std::vector<Parsed> parsed(chunkBegins.size());
+        QtConcurrent::blockingMap(chunkBegins, [&](int begin) {
+            Parsed& chunk = parsed[(begin - 1) / rowsPerChunk];
+            int end = std::min(begin + rowsPerChunk, dataRows + 1);
+            auto arena = std::make_shared<PersonArena>();
+            for (int row = begin; row < end; ++row) {
+                if (isBlank(rows[row])) {
+                    continue;
+                }
+                Person person;
+                if (mapRow(rows[row], columns, defaultGroup, person, arena)) {
+                    chunk.persons.push_back(std::move(person));
+                } else {
+                    chunk.invalid++;
+                }
+            }
+        });
+        return parsed;
+    }
+    // Excel单元格的值转换为文本：电话等整数不使用科学计数法，日期统一为yyyy-MM-dd
+    static QString cellText(const QVariant& cell) {
+        switch (cell.typeId()) {
+        case QMetaType::Double: {
+            double number = cell.toDouble();
+            if (number == static_cast<double>(static_cast<qlonglong>(number))) {
+                return QString::number(static_cast<qlonglong>(number));
+            }
+            return QString::number(number);
+        }
+        case QMetaType::QDate:
+        case QMetaType::QDateTime:
+            return cell.toDate().toString("yyyy-MM-dd");
+        default:
+            return cell.toString();
+        }
+    }
+};
@@ -1,19 +1,239 @@
 // main.cpp文件
 // 是系统的入口，用于启动系统。
 // 初始化并启动SystemWindow
+// 以“--serve [套接字名称]”参数启动时不显示窗口，作为花名册本地服务运行（见serviceFunction.h）
+// 以“--schedule-units 单位目录...”参数启动时不显示窗口，并行排各单位的班并输出合并结果（见unitFunction.h）
+// 以“--what-if [单位目录] [--replay]”参数启动时不显示窗口，分析哪些队员缺席会使时间段排不满（见simulationFunction.h），
+// 单位目录格式与多单位排班相同，默认为data目录；指定--replay时实际重放排班，否则只做可行性检查
+// 以“--generate 文件名 人数 [选项]”参数启动时不显示窗口，生成压力测试用的模拟花名册（见generatorFunction.h），选项：
+// --groups 一组,二组,三组,四组（人数比例） --density 有空比例 --correlation 同班相关度 --class-size 班级人数
+// --work-ratio 参加排班比例 --seed 随机数种子
+// 以“--duty-sheets 输出目录 [单位目录]”参数启动时不显示窗口，排一次班并为每名队员和每个组导出PDF执勤表（见sheetFunction.h），
+// 单位目录格式与多单位排班相同，默认为data目录；未设置QT_QPA_PLATFORM时使用offscreen平台，不需要显示器
+// 设置环境变量FLAG_GROUP_TRACE为文件名时，记录界面操作与重绘的耗时，窗口关闭后写出Chrome追踪文件（见traceFunction.h）
 #include "systemwindow.h"
+#include "serviceFunction.h"
+#include "unitFunction.h"
+#include "simulationFunction.h"
+#include "generatorFunction.h"
+#include "sheetFunction.h"
+#include "traceFunction.h"
+#include <QElapsedTimer>
 #include <QApplication>
+#include <QGuiApplication>
+#include <QCoreApplication>
 
 using namespace std;
 
+// TracingApplication 类定义，启用界面耗时追踪时，记录每次重绘与鼠标、键盘事件的处理耗时
+// 槽函数在鼠标、键盘事件的处理过程中被调用，在时间轴上嵌套在对应的输入事件之内；
+// 一个窗口的重绘由UpdateRequest发起，其中各控件的Paint事件嵌套在内
+class TracingApplication : public QApplication
+{
+public:
+    TracingApplication(int &argc, char **argv) : QApplication(argc, argv) {}
+
+    bool notify(QObject *receiver, QEvent *event) override {
+        const char* category = traceCategory(event->type());
+        if (!category || !UiTracer::instance().isEnabled()) {
+            return QApplication::notify(receiver, event);
+        }
+        UiTracer::Clock::time_point start = UiTracer::Clock::now();
+        bool result = QApplication::notify(receiver, event);
+        UiTracer::Clock::time_point end = UiTracer::Clock::now();
+        // 事件名称：事件类型 控件类名(对象名)，如 Paint QListView(group1_info_listView)
+        QByteArray name = QByteArray(eventName(event->type())) + " " + receiver->metaObject()->className();
+        if (!receiver->objectName().isEmpty()) {
+            name += "(" + receiver->objectName().toUtf8() + ")";
+        }
+        UiTracer::instance().record(name.toStdString(), category, start, end);
+        return result;
+    }
+
+private:
+    static const char* traceCategory(QEvent::Type type) {
+        switch (type) {
+        case QEvent::Paint:
+        case QEvent::UpdateRequest:
+            return "paint";
+        case QEvent::MouseButtonPress:
+        case QEvent::MouseButtonRelease:
+        case QEvent::MouseButtonDblClick:
+        case QEvent::KeyPress:
+            return "input";
+        default:
+            return nullptr;
+        }
+    }
+    static const char* eventName(QEvent::Type type) {
+        switch (type) {
+        case QEvent::Paint: return "Paint";
+        case QEvent::UpdateRequest: return "UpdateRequest";
+        case QEvent::MouseButtonPress: return "MouseButtonPress";
+        case QEvent::MouseButtonRelease: return "MouseButtonRelease";
+        case QEvent::MouseButtonDblClick: return "MouseButtonDblClick";
+        case QEvent::KeyPress: return "KeyPress";
+        default: return "Event";
+        }
+    }
+};
+
 int main(int argc, char *argv[])
 {
-    QApplication a(argc, argv);
+    // 服务模式
+    for (int i = 1; i < argc; ++i) {
+        if (QString(argv[i]) == "--serve") {
+            QCoreApplication a(argc, argv);
+            QString serverName = (i + 1 < argc) ? QString(argv[i + 1]) : QString("flag-group-roster");
+            RosterService service("./data/data.txt", "./data/sites.txt");
+            if (!service.listen(serverName)) {
+                qCritical() << "无法启动花名册服务：" << service.errorString();
+                return 1;
+            }
+            qInfo() << "花名册服务已启动：" << service.fullServerName();
+            return a.exec();
+        }
+        if (QString(argv[i]) == "--schedule-units") {
+            QCoreApplication a(argc, argv);
+            std::vector<SchedulingUnit> units;
+            for (int j = i + 1; j < argc; ++j) {
+                SchedulingUnit unit;
+                if (!MultiUnitScheduler::loadUnit(QString::fromLocal8Bit(argv[j]), unit)) {
+                    qCritical() << "单位目录中没有data.txt：" << argv[j];
+                    return 1;
+                }
+                units.push_back(unit);
+            }
+            QTextStream(stdout) << MultiUnitScheduler::merge(MultiUnitScheduler::scheduleAll(units));
+            return 0;
+        }
+        if (QString(argv[i]) == "--generate") {
+            QCoreApplication a(argc, argv);
+            // 参数有误时给出原因和用法并退出，不改动目标文件
+            auto usage = [](const QString& reason) {
+                qCritical().noquote() << reason;
+                qCritical() << "用法：--generate 文件名 人数 [--groups a,b,c,d] [--density p] [--correlation c] "
+                               "[--class-size n] [--work-ratio r] [--seed s]";
+                return 1;
+            };
+            if (i + 2 >= argc) {
+                return usage("缺少文件名或人数");
+            }
+            QString filename = QString::fromLocal8Bit(argv[i + 1]);
+            RosterGenerator::Options options;
+            bool ok = false;
+            options.members = QString(argv[i + 2]).toLongLong(&ok);
+            if (!ok || options.members <= 0) {
+                return usage(QString("人数须为正整数：%1").arg(argv[i + 2]));
+            }
+            // 读取0~1之间的比例
+            auto ratio = [&ok](const QString& value) {
+                double result = value.toDouble(&ok);
+                ok = ok && result >= 0 && result <= 1;
+                return result;
+            };
+            for (int j = i + 3; j < argc; j += 2) {
+                QString option = argv[j];
+                if (j + 1 >= argc) {
+                    return usage("选项缺少取值：" + option);
+                }
+                QString value = argv[j + 1];
+                if (option == "--groups") {
+                    QStringList weights = value.split(',');
+                    ok = weights.size() == 4;
+                    for (int group = 0; ok && group < 4; ++group) {
+                        options.groupWeights[group] = weights[group].toDouble(&ok);
+                        ok = ok && options.groupWeights[group] >= 0;
+                    }
+                } else if (option == "--density") {
+                    options.density = ratio(value);
+                } else if (option == "--correlation") {
+                    options.correlation = ratio(value);
+                } else if (option == "--class-size") {
+                    options.classSize = value.toInt(&ok);
+                    ok = ok && options.classSize >= 1;
+                } else if (option == "--work-ratio") {
+                    options.workRatio = ratio(value);
+                } else if (option == "--seed") {
+                    options.seed = value.toULongLong(&ok);
+                } else {
+                    return usage("无法识别的选项：" + option);
+                }
+                if (!ok) {
+                    return usage("选项" + option + "的取值无效：" + value);
+                }
+            }
+            QElapsedTimer timer;
+            timer.start();
+            qint64 written = RosterGenerator::generate(filename, options);
+            if (written < 0) {
+                qCritical() << "无法写入文件：" << filename;
+                return 1;
+            }
+            qInfo() << "已生成" << written << "名队员，用时" << timer.elapsed() << "毫秒：" << filename;
+            return 0;
+        }
+        if (QString(argv[i]) == "--what-if") {
+            QCoreApplication a(argc, argv);
+            QString directory = "./data";
+            WhatIfSimulator::Mode mode = WhatIfSimulator::FeasibilityCheck;
+            for (int j = i + 1; j < argc; ++j) {
+                if (QString(argv[j]) == "--replay") {
+                    mode = WhatIfSimulator::ScheduleReplay;
+                } else {
+                    directory = QString::fromLocal8Bit(argv[j]);
+                }
+            }
+            SchedulingUnit unit;
+            if (!MultiUnitScheduler::loadUnit(directory, unit)) {
+                qCritical() << "单位目录中没有data.txt：" << directory;
+                return 1;
+            }
+            WhatIfSimulator simulator(unit.roster, unit.useTotalTimesRule, unit.handoverRule, unit.registry, unit.seed);
+            QTextStream(stdout) << simulator.format(simulator.analyze(mode));
+            return 0;
+        }
+        if (QString(argv[i]) == "--duty-sheets") {
+            if (i + 1 >= argc) {
+                qCritical() << "用法：--duty-sheets 输出目录 [单位目录]";
+                return 1;
+            }
+            if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM")) {
+                qputenv("QT_QPA_PLATFORM", "offscreen"); // 绘制PDF需要字体，但不需要显示器
+            }
+            QGuiApplication a(argc, argv);
+            QString outputDirectory = QString::fromLocal8Bit(argv[i + 1]);
+            QString directory = (i + 2 < argc) ? QString::fromLocal8Bit(argv[i + 2]) : QString("./data");
+            SchedulingUnit unit;
+            if (!MultiUnitScheduler::loadUnit(directory, unit)) {
+                qCritical() << "单位目录中没有data.txt：" << directory;
+                return 1;
+            }
+            // 与窗口制表相同：周一至周五排本周，周六、周日排下一周
+            QDate today = QDate::currentDate();
+            QDate monday = today.addDays(1 - today.dayOfWeek()).addDays(today.dayOfWeek() >= 6 ? 7 : 0);
+            std::vector<UnitResult> results = MultiUnitScheduler::scheduleAll({unit});
+            for (const QString& warning : results[0].warnings) {
+                qWarning().noquote() << warning;
+            }
+            QElapsedTimer timer;
+            timer.start();
+            DutySheetRenderer renderer(results[0].registry, DutyWeek::of(results[0].table, monday));
+            int written = renderer.render(outputDirectory);
+            if (written < 0) {
+                qCritical() << "无法创建输出目录：" << outputDirectory;
+                return 1;
+            }
+            qInfo() << "已导出" << written << "/" << renderer.sheetCount() << "张执勤表，用时" << timer.elapsed() << "毫秒：" << outputDirectory;
+            return written == renderer.sheetCount() ? 0 : 1;
+        }
+    }
+    TracingApplication a(argc, argv);
     SystemWindow w;
     w.show();
-    return a.exec();
+    int result = a.exec();
+    if (UiTracer::instance().isEnabled() && !UiTracer::instance().write()) {
+        qWarning() << "无法写入界面耗时追踪文件";
+    }
+    return result;
 }
-
-
-
-
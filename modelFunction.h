@@ -0,0 +1,125 @@
+// modelFunction.h头文件
+// 功能说明：为队员标签界面（四个组的QListView）提供列表模型RosterListModel
+// 模型本身不保存任何队员数据，显示时按行直接读取Flag_group中对应组的队员信息；
+// 队员的增、删、改都通过模型完成，模型只通知发生变化的那一行，界面无需整表重建
+
+#pragma once
+
+#include <QAbstractListModel>
+#include "Person.h"
+#include "Flag_group.h"
+
+// RosterListModel 类定义，一个组对应一个模型，随窗口创建，整个程序运行期间一直存在
+class RosterListModel : public QAbstractListModel
+{
+    Q_OBJECT // QObject宏定义
+
+public:
+    // 修改通知中表示排班信息（是否值周、执勤时间）的角色。标签只显示姓名，搜索索引也不收录排班信息，收到只含该角色的通知时不必刷新
+    static constexpr int DutyRole = Qt::UserRole + 1;
+
+    // 构造函数
+    // 参数：Flag_group：存放国旗班所有队员信息的容器。int groupNumber：模型对应的组别（1~4）
+    RosterListModel(Flag_group& flagGroup, int groupNumber, QObject* parent = nullptr)
+        : QAbstractListModel(parent), flagGroup(flagGroup), groupNumber(groupNumber) {}
+
+    // 行数即对应组的队员人数
+    int rowCount(const QModelIndex& parent = QModelIndex()) const override {
+        if (parent.isValid()) {
+            return 0; // 列表模型没有子节点
+        }
+        return static_cast<int>(flagGroup.getGroupMembers(groupNumber).size());
+    }
+    // 标签显示的内容，只有在界面真正需要绘制该行时才会被调用
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const override {
+        const auto& members = flagGroup.getGroupMembers(groupNumber);
+        if (!index.isValid() || static_cast<std::vector<Person>::size_type>(index.row()) >= members.size()) {
+            return QVariant();
+        }
+        if (role == Qt::DisplayRole) {
+            return QString::fromStdString(members[index.row()].getName()); // 标签显示队员姓名
+        }
+        return QVariant();
+    }
+
+    // 添加队员到本组末尾，返回新队员所在行
+    int addPerson(const Person& person) {
+        TraceScope trace("RosterListModel::addPerson", "model"); // 含界面与搜索索引响应通知的耗时
+        int row = rowCount();
+        beginInsertRows(QModelIndex(), row, row);
+        flagGroup.addPersonToGroup(person, groupNumber);
+        endInsertRows();
+        return row;
+    }
+    // 批量添加队员到本组末尾，只发出一次插入通知，返回第一名新队员所在行
+    int addPersons(const std::vector<Person>& persons) {
+        TraceScope trace("RosterListModel::addPersons", "model");
+        int row = rowCount();
+        if (persons.empty()) {
+            return row;
+        }
+        beginInsertRows(QModelIndex(), row, row + static_cast<int>(persons.size()) - 1);
+        flagGroup.addPersonsToGroup(persons, groupNumber);
+        endInsertRows();
+        return row;
+    }
+    // 同上，转移persons中的队员而不复制
+    int addPersons(std::vector<Person>&& persons) {
+        TraceScope trace("RosterListModel::addPersons", "model");
+        int row = rowCount();
+        if (persons.empty()) {
+            return row;
+        }
+        beginInsertRows(QModelIndex(), row, row + static_cast<int>(persons.size()) - 1);
+        flagGroup.addPersonsToGroup(std::move(persons), groupNumber);
+        endInsertRows();
+        return row;
+    }
+    // 从本组删除指定的队员，判定规则与Flag_group::removePersonFromGroup一致
+    bool removePerson(const Person& person) {
+        TraceScope trace("RosterListModel::removePerson", "model");
+        int row = flagGroup.indexOfPersonInGroup(person, groupNumber); // 删除前先确定行号
+        if (row < 0) {
+            return false;
+        }
+        beginRemoveRows(QModelIndex(), row, row);
+        flagGroup.removePersonFromGroup(person, groupNumber);
+        endRemoveRows();
+        return true;
+    }
+    // 修改本组中指定队员的信息，只刷新被修改的那一行
+    bool modifyPerson(const Person& oldPerson, const Person& newPerson) {
+        TraceScope trace("RosterListModel::modifyPerson", "model");
+        int row = flagGroup.modifyPersonInGroup(oldPerson, newPerson, groupNumber);
+        if (row < 0) {
+            return false;
+        }
+        emit dataChanged(index(row), index(row), {Qt::DisplayRole});
+        return true;
+    }
+    // 批量修改本组队员，参数与Flag_group::editGroup相同。全部修改完成后只发出一次修改通知，覆盖被修改的行，
+    // 界面与搜索索引每批只刷新一次，不会因逐个修改大组的队员而反复刷新
+    // roles：修改涉及的内容，只修改排班信息时传入{DutyRole}。返回是否有队员被修改
+    template <class Edit>
+    bool editMembers(Edit&& edit, const QList<int>& roles = {Qt::DisplayRole}) {
+        TraceScope trace("RosterListModel::editMembers", "model");
+        std::pair<int, int> changed = flagGroup.editGroup(groupNumber, std::forward<Edit>(edit));
+        if (changed.first < 0) {
+            return false;
+        }
+        emit dataChanged(index(changed.first), index(changed.second), roles);
+        return true;
+    }
+    // Flag_group被整体替换（如重新读取文件）后调用，通知界面重新读取整个组
+    void reload() {
+        TraceScope trace("RosterListModel::reload", "model");
+        beginResetModel();
+        endResetModel();
+    }
+
+    int getGroupNumber() const { return groupNumber; }
+
+private:
+    Flag_group& flagGroup; // 国旗班容器，模型直接读取其中的队员信息
+    int groupNumber; // 模型对应的组别，值为1~4
+};
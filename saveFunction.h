@@ -0,0 +1,81 @@
+// saveFunction.h头文件
+// 功能说明：后台保存花名册RosterSaver
+// 窗口运行期间定时保存，不必等到关闭窗口：没有修改时不保存；只修改了少数队员且记录长度不变时在当前线程原位覆盖，
+// 只写几十个字节；需要整体重写时把花名册快照（写时复制，只复制队员指针）交给后台线程写入，界面不会卡顿
+// 后台写入完成后回到界面线程更新各队员的记录位置与修改标记，写入期间的新修改保留到下一次保存
+
+#pragma once
+
+#include <QObject>
+#include <QFutureWatcher>
+#include <QtConcurrent/QtConcurrent>
+#include "Flag_group.h"
+#include "fileFunction.h"
+
+// RosterSaver 类定义，后台保存花名册
+class RosterSaver : public QObject
+{
+    Q_OBJECT // QObject宏定义
+
+public:
+    // 参数：Flag_group：要保存的花名册，只在界面线程中访问。QString filename：数据文件名
+    RosterSaver(Flag_group& flagGroup, const QString& filename, QObject* parent = nullptr)
+        : QObject(parent), flagGroup(flagGroup), filename(filename) {
+        connect(&watcher, &QFutureWatcher<FlagGroupFileManager::SaveResult>::finished, this, &RosterSaver::onWriteFinished);
+    }
+
+    // 保存一次。已有后台写入时，等写入完成后再保存一次
+    void save() {
+        if (!applied) {
+            saveAgain = true;
+            return;
+        }
+        if (!flagGroup.isDirty() || FlagGroupFileManager::patchFile(flagGroup, filename)) {
+            return;
+        }
+        snapshot = flagGroup;
+        snapshotRevision = flagGroup.getLayoutRevision(); // 赋值会增加snapshot自己的计数，单独记下取快照时的值
+        applied = false;
+        // 后台线程使用自己的一份快照，界面线程中的snapshot只用于写入完成后的比较
+        watcher.setFuture(QtConcurrent::run([written = snapshot, target = filename]() {
+            return FlagGroupFileManager::writeSnapshot(written, target);
+        }));
+    }
+    // 等待后台写入完成并保存剩余的修改，关闭窗口时调用
+    void flush() {
+        if (!applied) {
+            watcher.waitForFinished();
+            saveAgain = false; // 剩余的修改在下面同步保存
+            onWriteFinished(); // 窗口即将关闭，不再回到事件循环，直接应用写入结果
+        }
+        FlagGroupFileManager::saveToFile(flagGroup, filename);
+    }
+
+signals:
+    void saved(bool ok); // 一次后台写入完成
+
+private:
+    Flag_group& flagGroup; // 要保存的花名册
+    QString filename; // 数据文件名
+    Flag_group snapshot; // 正在后台写入的花名册快照
+    long long snapshotRevision = 0; // 取快照时花名册的增删次数
+    QFutureWatcher<FlagGroupFileManager::SaveResult> watcher; // 后台写入任务
+    bool saveAgain = false; // 后台写入期间又请求了保存
+    bool applied = true; // 本次写入结果是否已应用
+
+    // 后台写入完成
+    void onWriteFinished() {
+        if (applied) {
+            return; // 关闭窗口时已直接应用
+        }
+        applied = true;
+        FlagGroupFileManager::SaveResult result = watcher.result();
+        FlagGroupFileManager::applySaveResult(flagGroup, snapshot, snapshotRevision, result);
+        snapshot = Flag_group(); // 释放快照，之后修改队员不必再复制数据
+        emit saved(result.ok);
+        if (saveAgain) {
+            saveAgain = false;
+            save();
+        }
+    }
+};
@@ -0,0 +1,265 @@
+// searchFunction.h头文件
+// 功能说明：提供队员搜索索引MemberSearchIndex，支持按姓名、专业班级即时搜索
+// 索引以Unicode字符为单位，为每个字段建立单字与相邻两字（二元组）的倒排表。中文按字切分，不受UTF-8多字节编码影响
+// 索引监听四个组的队员标签模型，随队员的增删改增量更新，搜索时无需遍历全部队员
+// 电话、寝室号、学院属于延迟读取的档案信息，为其建立索引需要逐个从磁盘读出全部队员的档案，因此不建立索引
+// 索引在第一次搜索时才建立，不使用搜索时不占用内存
+// 失效记录过多时索引会整理重建，记录编号随之改变，整理前得到的搜索结果以整理次数识别为过期
+
+#pragma once
+
+#include <QObject>
+#include <QString>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <iterator>
+#include "Person.h"
+#include "Flag_group.h"
+#include "modelFunction.h"
+
+// MemberSearchIndex 类定义，队员搜索索引
+class MemberSearchIndex : public QObject
+{
+    Q_OBJECT // QObject宏定义
+
+public:
+    // 搜索结果
+    struct Result {
+        int groupNumber; // 命中队员的组别，值为1~4
+        int docId; // 命中队员在索引中的编号，点击结果时通过rowOf换算为组内行号
+        QString name; // 命中队员的姓名，用于显示
+        int generation; // 得到结果时索引的整理次数，索引整理后记录编号失效
+    };
+
+    // 构造函数
+    // 参数：Flag_group：存放国旗班所有队员信息的容器，索引建立与更新时从中读取队员信息
+    MemberSearchIndex(const Flag_group& flagGroup, QObject* parent = nullptr)
+        : QObject(parent), flagGroup(flagGroup) {}
+
+    // 监听一个组的队员标签模型，索引已建立时为该组现有队员建立索引
+    void attachModel(RosterListModel* model) {
+        int groupNumber = model->getGroupNumber();
+        connect(model, &QAbstractItemModel::rowsInserted, this, [this, groupNumber](const QModelIndex&, int first, int last) {
+            onRowsInserted(groupNumber, first, last);
+        });
+        connect(model, &QAbstractItemModel::rowsRemoved, this, [this, groupNumber](const QModelIndex&, int first, int last) {
+            onRowsRemoved(groupNumber, first, last);
+        });
+        connect(model, &QAbstractItemModel::dataChanged, this, [this, groupNumber](const QModelIndex& topLeft, const QModelIndex& bottomRight, const QList<int>& roles) {
+            if (roles.size() == 1 && roles.first() == RosterListModel::DutyRole) {
+                return; // 只修改了排班信息，索引的字段不变
+            }
+            onRowsChanged(groupNumber, topLeft.row(), bottomRight.row());
+        });
+        connect(model, &QAbstractItemModel::modelReset, this, [this, groupNumber]() {
+            onGroupReset(groupNumber);
+        });
+        onGroupReset(groupNumber);
+    }
+
+    // 搜索函数
+    // 参数：QString query：用户输入的关键字。int maxResults：最多返回的结果数
+    // 先用关键字的单字/二元组倒排表求交集得到候选队员，再对候选逐一确认关键字完整出现在某个字段中
+    // 第一次搜索时为全部队员建立索引
+    std::vector<Result> search(const QString& query, int maxResults = 100) {
+        std::vector<Result> results;
+        if (!built) {
+            built = true;
+            for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+                onGroupReset(groupNumber);
+            }
+        }
+        QString folded = query.trimmed().toCaseFolded(); // 忽略英文大小写差异
+        const auto keyword = folded.toUcs4();
+        if (keyword.isEmpty()) {
+            return results;
+        }
+        // 收集关键字所有二元组（单字关键字则使用单字）对应的倒排表
+        std::vector<const std::vector<int>*> lists;
+        if (keyword.size() == 1) {
+            auto it = postings.find(unigramKey(keyword[0]));
+            if (it == postings.end()) {
+                return results;
+            }
+            lists.push_back(&it->second);
+        } else {
+            for (int i = 0; i + 1 < keyword.size(); ++i) {
+                auto it = postings.find(bigramKey(keyword[i], keyword[i + 1]));
+                if (it == postings.end()) {
+                    return results; // 有一个二元组从未出现过，不可能命中
+                }
+                lists.push_back(&it->second);
+            }
+        }
+        // 从最短的倒排表开始求交集，候选数量会迅速缩小
+        std::sort(lists.begin(), lists.end(), [](const std::vector<int>* a, const std::vector<int>* b) {
+            return a->size() < b->size();
+        });
+        std::vector<int> candidates = *lists[0];
+        std::vector<int> merged;
+        for (size_t i = 1; i < lists.size() && !candidates.empty(); ++i) {
+            merged.clear();
+            std::set_intersection(candidates.begin(), candidates.end(), lists[i]->begin(), lists[i]->end(), std::back_inserter(merged));
+            candidates.swap(merged);
+        }
+        // 逐一确认候选队员
+        // 一到两个字的关键字由倒排表本身即可保证命中；更长的关键字还需确认各二元组是连续出现的
+        for (int docId : candidates) {
+            const Doc& doc = docs[docId];
+            if (!doc.alive) {
+                continue; // 已被删除或修改过的旧记录
+            }
+            if (keyword.size() > 2 && !doc.text.contains(folded)) {
+                continue;
+            }
+            results.push_back({doc.groupNumber, docId, doc.name, generation});
+            if (static_cast<int>(results.size()) >= maxResults) {
+                break;
+            }
+        }
+        return results;
+    }
+
+    // 将搜索结果换算为组内行号，结果已过期（队员已被删除或修改，或索引已整理）时返回-1
+    int rowOf(const Result& result) const {
+        if (result.groupNumber < 1 || result.groupNumber > 4 || result.generation != generation) {
+            return -1;
+        }
+        const std::vector<int>& rows = rowDocs[result.groupNumber - 1];
+        auto it = std::find(rows.begin(), rows.end(), result.docId);
+        return it == rows.end() ? -1 : static_cast<int>(it - rows.begin());
+    }
+
+private:
+    // 索引中的一条队员记录
+    struct Doc {
+        int groupNumber; // 组别
+        bool alive; // 是否有效，队员被删除或修改后旧记录失效，待整理时回收
+        QString name; // 姓名，用于显示搜索结果
+        QString text; // 各字段转小写后以换行符拼接的全文，用于确认长关键字
+    };
+
+    const Flag_group& flagGroup; // 国旗班容器
+    std::vector<Doc> docs; // 全部索引记录，编号即下标，只追加不移动，保证倒排表有序
+    std::vector<int> rowDocs[4]; // 四个组每一行对应的记录编号，与组内队员顺序保持一致
+    std::unordered_map<quint64, std::vector<int>> postings; // 倒排表：单字/二元组 -> 记录编号（升序）
+    int deadCount = 0; // 失效记录数
+    int generation = 0; // 索引整理次数，整理后之前的记录编号全部失效
+    bool built = false; // 索引是否已建立，建立前忽略模型信号
+
+    static quint64 unigramKey(uint c) {
+        return c;
+    }
+    static quint64 bigramKey(uint a, uint b) {
+        return (static_cast<quint64>(a) << 32) | b; // 首字不为0，不会与单字键冲突
+    }
+
+    // 为一名队员建立索引记录，返回记录编号
+    int addDoc(int groupNumber, const Person& person) {
+        int docId = static_cast<int>(docs.size());
+        // 只读取常驻内存的字段，不触发档案信息的延迟读取
+        QString fields[] = {
+            QString::fromStdString(person.getName()),
+            QString::fromStdString(person.getClassname())
+        };
+        std::vector<quint64> keys;
+        QString text;
+        for (const QString& field : fields) {
+            QString folded = field.toCaseFolded();
+            const auto chars = folded.toUcs4();
+            for (int i = 0; i < chars.size(); ++i) {
+                keys.push_back(unigramKey(chars[i]));
+                if (i + 1 < chars.size()) {
+                    keys.push_back(bigramKey(chars[i], chars[i + 1]));
+                }
+            }
+            text += folded + QChar('\n');
+        }
+        // 同一记录在一个倒排表中只出现一次
+        std::sort(keys.begin(), keys.end());
+        keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+        for (quint64 key : keys) {
+            postings[key].push_back(docId);
+        }
+        docs.push_back({groupNumber, true, fields[0], text});
+        return docId;
+    }
+    // 使一条记录失效，倒排表中的编号留待整理时统一清除
+    void removeDoc(int docId) {
+        docs[docId].alive = false;
+        docs[docId].name.clear();
+        docs[docId].text.clear();
+        ++deadCount;
+    }
+    // 失效记录过多时重建索引，回收倒排表空间
+    void compactIfNeeded() {
+        int liveCount = static_cast<int>(docs.size()) - deadCount;
+        if (deadCount < 1024 || deadCount < liveCount) {
+            return;
+        }
+        docs.clear();
+        postings.clear();
+        deadCount = 0;
+        ++generation;
+        for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+            std::vector<int>& rows = rowDocs[groupNumber - 1];
+            const auto& members = flagGroup.getGroupMembers(groupNumber);
+            for (size_t row = 0; row < rows.size() && row < members.size(); ++row) {
+                rows[row] = addDoc(groupNumber, members[row]);
+            }
+        }
+    }
+
+    // 模型信号的处理函数
+    void onRowsInserted(int groupNumber, int first, int last) {
+        if (!built) {
+            return;
+        }
+        const auto& members = flagGroup.getGroupMembers(groupNumber);
+        std::vector<int> ids;
+        for (int row = first; row <= last; ++row) {
+            ids.push_back(addDoc(groupNumber, members[row]));
+        }
+        std::vector<int>& rows = rowDocs[groupNumber - 1];
+        rows.insert(rows.begin() + first, ids.begin(), ids.end());
+    }
+    void onRowsRemoved(int groupNumber, int first, int last) {
+        if (!built) {
+            return;
+        }
+        std::vector<int>& rows = rowDocs[groupNumber - 1];
+        for (int row = first; row <= last; ++row) {
+            removeDoc(rows[row]);
+        }
+        rows.erase(rows.begin() + first, rows.begin() + last + 1);
+        compactIfNeeded();
+    }
+    void onRowsChanged(int groupNumber, int first, int last) {
+        if (!built) {
+            return;
+        }
+        const auto& members = flagGroup.getGroupMembers(groupNumber);
+        std::vector<int>& rows = rowDocs[groupNumber - 1];
+        for (int row = first; row <= last; ++row) {
+            removeDoc(rows[row]);
+            rows[row] = addDoc(groupNumber, members[row]);
+        }
+        compactIfNeeded();
+    }
+    void onGroupReset(int groupNumber) {
+        if (!built) {
+            return;
+        }
+        std::vector<int>& rows = rowDocs[groupNumber - 1];
+        for (int docId : rows) {
+            removeDoc(docId);
+        }
+        rows.clear();
+        const auto& members = flagGroup.getGroupMembers(groupNumber);
+        for (const auto& member : members) {
+            rows.push_back(addDoc(groupNumber, member));
+        }
+        compactIfNeeded();
+    }
+};
@@ -0,0 +1,260 @@
+// serviceFunction.h头文件
+// 功能说明：花名册本地服务RosterService，以“--serve”参数启动，不显示窗口
+// 服务常驻内存保存Flag_group，通过本地套接字（Linux下为Unix域套接字，仅本机可访问）为考勤机、统计脚本等工具提供花名册查询与排班
+// 数据文件被窗口程序保存后自动重新读取，客户端无需、也无法触发每次重新读取data.txt
+//
+// 通信协议：UTF-8文本，一行一个请求，每个请求按发送顺序返回一个响应
+// 客户端可以连续发送多个请求而不必等待响应（流水线）；服务在一次事件循环中收集所有客户端已到达的完整请求，
+// 统一处理后每个客户端的响应合并为一次写入（批处理）
+// 响应：成功为“OK 行数”，其后为若干数据行；失败为一行“ERR 说明”。数据行的字段以“|”分隔
+//   PING                         测试连接，返回0行
+//   COUNT                        各组人数，返回1行：一组|二组|三组|四组
+//   LIST 组别                    该组全部队员，每行：姓名|性别|组别|专业班级|是否值周|本周次数|总次数
+//   FIND 关键字                   按姓名、专业班级搜索，每行：组别|姓名
+//   MEMBER 姓名                  同名队员的全部信息，每行：姓名|性别|组别|电话|籍贯|民族|寝室号|学院|专业班级|生日|是否值周|本周次数|总次数
+//   SCHEDULE [TOTAL] [MONDAY|ALL] [SEED 种子]
+//                                按数据文件中的是否值周信息排一周班，不修改花名册；
+//                                每行：时间段|地点|说明|队员1,队员2,队员3，排班警告以“#”开头
+//                                指定种子时结果可复现，花名册与选项未变的重复请求直接返回缓存的结果
+//   QUIT                         处理完之前的请求后断开连接
+
+#pragma once
+
+#include <QObject>
+#include <QLocalServer>
+#include <QLocalSocket>
+#include <QFileSystemWatcher>
+#include <QFileInfo>
+#include <QPointer>
+#include <QTimer>
+#include <QStringList>
+#include <vector>
+#include <unordered_map>
+#include "Flag_group.h"
+#include "fileFunction.h"
+#include "dataFunction.h"
+#include "searchFunction.h"
+#include "siteFunction.h"
+
+// RosterService 类定义，花名册本地服务
+class RosterService : public QObject
+{
+    Q_OBJECT // QObject宏定义
+
+public:
+    // 构造函数
+    // 参数：QString dataFile：队员数据文件。QString siteFile：执勤地点与仪式配置文件
+    RosterService(const QString& dataFile, const QString& siteFile, QObject* parent = nullptr)
+        : QObject(parent), dataFile(dataFile) {
+        registry.load(siteFile);
+        reload();
+        // 数据文件变化后稍等片刻再重新读取，窗口程序连续写入时只读取一次
+        reloadTimer.setSingleShot(true);
+        reloadTimer.setInterval(200);
+        connect(&reloadTimer, &QTimer::timeout, this, &RosterService::reload);
+        connect(&watcher, &QFileSystemWatcher::fileChanged, this, [this]() { reloadTimer.start(); });
+        // 数据文件所在目录同时受监视：启动时数据文件还不存在、或被删除后再建立时，文件出现后读取并开始监视
+        connect(&watcher, &QFileSystemWatcher::directoryChanged, this, [this]() {
+            if (QFileInfo::exists(dataFile) && !watcher.files().contains(dataFile)) {
+                reloadTimer.start();
+            }
+        });
+        connect(&server, &QLocalServer::newConnection, this, &RosterService::onNewConnection);
+    }
+
+    // 开始监听，参数：QString serverName：套接字名称，客户端以同一名称连接
+    bool listen(const QString& serverName) {
+        QLocalServer::removeServer(serverName); // 清除上次异常退出遗留的套接字文件
+        server.setSocketOptions(QLocalServer::UserAccessOption); // 只允许当前用户连接
+        return server.listen(serverName);
+    }
+    QString errorString() const { return server.errorString(); }
+    QString fullServerName() const { return server.fullServerName(); }
+
+private:
+    // 一个待处理的请求
+    struct Request {
+        QPointer<QLocalSocket> client; // 发出请求的客户端，处理前断开连接时自动置空
+        QByteArray line; // 请求内容，不含换行
+    };
+
+    QString dataFile; // 队员数据文件
+    Flag_group flagGroup; // 常驻内存的花名册
+    SiteRegistry registry; // 执勤地点与仪式登记表
+    MemberSearchIndex* searchIndex = nullptr; // 队员搜索索引，第一次FIND时建立
+    QLocalServer server; // 本地套接字服务
+    QFileSystemWatcher watcher; // 监视数据文件的修改，以及数据文件所在目录中文件的出现
+    QTimer reloadTimer; // 重新读取数据文件的延时
+    std::vector<Request> pending; // 本轮收集到的请求，按到达顺序排列
+    bool flushQueued = false; // 是否已安排本轮处理
+
+    // 读取数据文件，替换常驻的花名册
+    void reload() {
+        Flag_group loaded;
+        // 服务运行期间数据文件随时可能被窗口程序改写，档案信息不能延迟到以后再按位置读取，读取时一并读出
+        FlagGroupFileManager::loadFromFile(loaded, dataFile, false);
+        flagGroup = loaded;
+        delete searchIndex; // 搜索索引随花名册整体替换而失效，下次搜索时重新建立
+        searchIndex = new MemberSearchIndex(flagGroup, this);
+        // 数据文件以改名方式整体替换后监视会失效，重新加入；数据文件还不存在时由目录监视等待它出现
+        QString directory = QFileInfo(dataFile).absolutePath();
+        if (QFileInfo::exists(directory) && !watcher.directories().contains(directory)) {
+            watcher.addPath(directory);
+        }
+        if (QFileInfo::exists(dataFile) && !watcher.files().contains(dataFile)) {
+            watcher.addPath(dataFile);
+        }
+    }
+
+    void onNewConnection() {
+        while (QLocalSocket* client = server.nextPendingConnection()) {
+            connect(client, &QLocalSocket::readyRead, this, [this, client]() { onReadyRead(client); });
+            connect(client, &QLocalSocket::disconnected, client, &QObject::deleteLater);
+        }
+    }
+    // 收集客户端已到达的完整请求，不完整的一行留在套接字缓冲区中等待后续数据
+    void onReadyRead(QLocalSocket* client) {
+        while (client->canReadLine()) {
+            QByteArray line = client->readLine();
+            while (line.endsWith('\n') || line.endsWith('\r')) {
+                line.chop(1);
+            }
+            pending.push_back({client, line});
+        }
+        if (!pending.empty() && !flushQueued) {
+            // 本轮事件循环中其他客户端的请求也会加入pending，回到事件循环后一并处理
+            flushQueued = true;
+            QMetaObject::invokeMethod(this, &RosterService::flush, Qt::QueuedConnection);
+        }
+    }
+    // 统一处理本轮收集到的请求，每个客户端的响应合并为一次写入
+    void flush() {
+        flushQueued = false;
+        std::vector<Request> batch;
+        batch.swap(pending);
+        std::vector<QPointer<QLocalSocket>> clients; // 本轮有请求的客户端，保持首次出现的顺序
+        std::unordered_map<QLocalSocket*, QByteArray> replies;
+        std::unordered_map<QLocalSocket*, bool> quitting;
+        for (const Request& request : batch) {
+            QLocalSocket* client = request.client;
+            if (!client || quitting[client]) {
+                continue; // 客户端已断开，或已请求断开
+            }
+            if (!replies.count(client)) {
+                clients.push_back(request.client);
+            }
+            if (request.line.trimmed() == "QUIT") {
+                quitting[client] = true;
+                replies[client] += "OK 0\n";
+                continue;
+            }
+            replies[client] += handle(QString::fromUtf8(request.line));
+        }
+        for (const QPointer<QLocalSocket>& client : clients) {
+            if (!client) {
+                continue;
+            }
+            client->write(replies[client.data()]);
+            if (quitting[client.data()]) {
+                client->disconnectFromServer(); // 写完缓冲区中的响应后断开
+            }
+        }
+    }
+
+    // 处理一个请求，返回完整的响应
+    QByteArray handle(const QString& line) {
+        QString command = line.section(' ', 0, 0).toUpper();
+        QString argument = line.section(' ', 1).trimmed();
+        QStringList rows;
+        if (command == "PING") {
+            // 无数据行
+        } else if (command == "COUNT") {
+            QStringList counts;
+            for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+                counts << QString::number(flagGroup.getGroupMembers(groupNumber).size());
+            }
+            rows << counts.join("|");
+        } else if (command == "LIST") {
+            bool ok = false;
+            int groupNumber = argument.toInt(&ok);
+            if (!ok || groupNumber < 1 || groupNumber > 4) {
+                return "ERR 组别应为1~4\n";
+            }
+            for (const auto& member : flagGroup.getGroupMembers(groupNumber)) {
+                rows << QStringList{QString::fromStdString(member.getName()), member.getGender() ? "女" : "男",
+                                    QString::number(member.getGroup()), QString::fromStdString(member.getClassname()),
+                                    member.getIsWork() ? "1" : "0", QString::number(member.getTimes()),
+                                    QString::number(member.getAll_times())}.join("|");
+            }
+        } else if (command == "FIND") {
+            if (argument.isEmpty()) {
+                return "ERR 缺少关键字\n";
+            }
+            for (const auto& result : searchIndex->search(argument)) {
+                rows << QString::number(result.groupNumber) + "|" + result.name;
+            }
+        } else if (command == "MEMBER") {
+            std::string name = argument.toStdString();
+            for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+                for (const auto& member : flagGroup.getGroupMembers(groupNumber)) {
+                    if (member.getName() == name) {
+                        rows << memberLine(member);
+                    }
+                }
+            }
+        } else if (command == "SCHEDULE") {
+            rows = schedule(argument.toUpper().split(' ', Qt::SkipEmptyParts));
+        } else {
+            return "ERR 无法识别的请求：" + line.toUtf8() + "\n";
+        }
+        QByteArray reply = "OK " + QByteArray::number(rows.size()) + "\n";
+        for (const QString& row : rows) {
+            reply += row.toUtf8() + "\n";
+        }
+        return reply;
+    }
+    // 队员的全部信息，字段顺序与数据文件一致（不含执勤时间）
+    static QString memberLine(const Person& member) {
+        return QStringList{QString::fromStdString(member.getName()), member.getGender() ? "女" : "男",
+                           QString::number(member.getGroup()), QString::fromStdString(member.getPhone_number()),
+                           QString::fromStdString(member.getNative_place()), QString::fromStdString(member.getNative()),
+                           QString::fromStdString(member.getDorm()), QString::fromStdString(member.getSchool()),
+                           QString::fromStdString(member.getClassname()), QString::fromStdString(member.getBirthday()),
+                           member.getIsWork() ? "1" : "0", QString::number(member.getTimes()),
+                           QString::number(member.getAll_times())}.join("|");
+    }
+    // 排班管理器在自己的花名册快照上排班，快照中的队员采用写时复制，排班修改执勤次数不影响常驻的花名册
+    QStringList schedule(const QStringList& options) {
+        bool useTotalTimesRule = options.contains("TOTAL");
+        SchedulingManager::HandoverRule handoverRule = SchedulingManager::NoRule;
+        if (options.contains("MONDAY")) {
+            handoverRule = SchedulingManager::MondayHandoverRule;
+        } else if (options.contains("ALL")) {
+            handoverRule = SchedulingManager::AllHandoverRule;
+        }
+        SchedulingManager manager(flagGroup, useTotalTimesRule, handoverRule, registry);
+        int seedIndex = options.indexOf("SEED");
+        if (seedIndex >= 0 && seedIndex + 1 < options.size()) {
+            manager.setSeed(options[seedIndex + 1].toULongLong());
+        }
+        QStringList rows;
+        connect(&manager, &SchedulingManager::schedulingWarning, this, [&rows](const QString& warning) {
+            rows << "#" + warning;
+        });
+        manager.schedule();
+        const ScheduleTable& table = manager.getScheduleTable();
+        for (int slot = 0; slot < table.slotCount(); ++slot) {
+            for (int location = 0; location < table.siteCount(); ++location) {
+                QStringList names;
+                for (Person* person : table.crew(slot, location)) {
+                    if (person) {
+                        names << QString::fromStdString(person->getName());
+                    }
+                }
+                rows << QString("%1|%2|%3|%4").arg(slot).arg(location)
+                            .arg(QString::fromStdString(registry.crewLabel(slot, location))).arg(names.join(","));
+            }
+        }
+        return rows;
+    }
+};
@@ -0,0 +1,313 @@
+// sheetFunction.h头文件
+// 功能说明：执勤表批量导出DutySheetRenderer，把一周的排班结果画成可打印的PDF执勤表，用于张贴在公告栏
+// 每名队员一张（列出本人执勤的各次任务及同班队员），每组一张（列出本组队员的执勤任务），
+// 使用QPdfWriter离屏绘制，不需要显示器，无窗口模式下也可以使用
+//
+// 各张执勤表之间没有关联，由线程池并行绘制，每张一个QPdfWriter。表头、行标题与网格线对所有执勤表都相同，
+// 只在构造时录制一次为QPicture，保存录制好的指令数据，每一页复制一份后回放（QPicture回放时会改动内部状态，
+// 不能由多个线程同时回放同一个）；字体同样只创建一次。绘制线程只读取构造时整理好的执勤表数据，
+// 不访问花名册与工作表格中的队员指针
+
+#pragma once
+
+#include <QDate>
+#include <QDir>
+#include <QFont>
+#include <QColor>
+#include <QPainter>
+#include <QFontDatabase>
+#include <QPicture>
+#include <QPageSize>
+#include <QPdfWriter>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <vector>
+#include <unordered_map>
+#include "dataFunction.h"
+#include "fileFunction.h"
+#include "siteFunction.h"
+
+// 一周排班结果的快照，每个岗位保存队员的编号、姓名与组别，岗位编号与ScheduleTable::index一致
+// 排班管理器在排班完成后即被删除，工作表格中的队员指针随之失效，需要导出执勤表时先保存这份快照
+struct DutyWeek
+{
+    // 一个岗位上的队员，id为0表示空岗
+    struct Seat {
+        int id = 0; // 队员编号
+        QString name; // 姓名
+        int group = 0; // 组别，1~4
+    };
+    std::vector<Seat> seats;
+    int locations = 0; // 每个时间段的地点数
+    QDate monday; // 该周的周一
+    bool valid = false; // 是否已保存过排班结果
+
+    // 某时间段某地点某岗位上的队员
+    const Seat& at(int slot, int location, int position) const {
+        return seats[(slot * locations + location) * ScheduleTable::peoplePerLocation + position];
+    }
+    static DutyWeek of(const ScheduleTable& table, const QDate& monday) {
+        DutyWeek week;
+        SeatView allSeats = table.allSeats();
+        week.seats.resize(allSeats.size());
+        week.locations = table.siteCount();
+        for (int seat = 0; seat < allSeats.size(); ++seat) {
+            if (const Person* person = allSeats[seat]) {
+                week.seats[seat] = {person->getId(), QString::fromStdString(person->getName()), person->getGroup()};
+            }
+        }
+        week.monday = monday;
+        week.valid = true;
+        return week;
+    }
+};
+
+// DutySheetRenderer 类定义，执勤表批量导出
+class DutySheetRenderer
+{
+public:
+    // 构造函数，整理出全部执勤表的内容并录制表格框架，须在界面线程（或无窗口模式的主线程）中构造
+    // 参数：SiteRegistry：执勤地点与仪式登记表，提供行标题与星期名称。DutyWeek：要导出的一周排班
+    DutySheetRenderer(const SiteRegistry& registry, const DutyWeek& week)
+        : days(registry.dayCount()), timeRows(registry.timeRowCount()), dayWidth((pageWidth - 2 * margin - labelWidth) / days),
+          rowHeight(std::min(maxRowHeight, rowsHeight / timeRows)) {
+        createFonts();
+        recordFrame(registry);
+        collectSheets(registry, week);
+    }
+
+    // 把全部执勤表写入directory，每张一个PDF文件，返回写出的文件数，目录无法创建时返回-1
+    // 参数：QThreadPool：绘制执勤表的线程池，默认为全局线程池（线程数等于CPU核数）
+    int render(const QString& directory, QThreadPool* pool = QThreadPool::globalInstance()) const {
+        QDir dir;
+        if (!dir.exists(directory) && !dir.mkpath(directory)) {
+            return -1;
+        }
+        std::vector<int> indexes(sheets.size());
+        std::iota(indexes.begin(), indexes.end(), 0);
+        std::vector<char> written(sheets.size(), 0);
+        auto renderOne = [this, &directory, &written](int index) {
+            written[index] = renderSheet(sheets[index], QDir(directory).filePath(sheets[index].filename));
+        };
+#if QT_VERSION < QT_VERSION_CHECK(6, 0, 0)
+        // Qt 5在部分平台上不支持在界面线程以外绘制文字，此时退回逐张绘制
+        if (!QFontDatabase::supportsThreadedFontRendering()) {
+            std::for_each(indexes.begin(), indexes.end(), renderOne);
+            return static_cast<int>(std::count(written.begin(), written.end(), 1));
+        }
+#endif
+        QtConcurrent::blockingMap(pool, indexes, renderOne);
+        return static_cast<int>(std::count(written.begin(), written.end(), 1));
+    }
+    int sheetCount() const { return static_cast<int>(sheets.size()); } // 执勤表张数
+
+private:
+    // 页面采用逻辑坐标，单位为0.1毫米，A4横向为2970×2100，与PDF的分辨率无关
+    static constexpr int pageWidth = 2970;
+    static constexpr int pageHeight = 2100;
+    static constexpr int margin = 150; // 页边距
+    static constexpr int tableTop = 420; // 表格上边缘，其上为标题
+    static constexpr int labelWidth = 420; // 行标题列宽
+    static constexpr int headerHeight = 150; // 表头行高
+    static constexpr int maxRowHeight = 320; // 表格行高的上限
+    static constexpr int rowsHeight = 1280; // 表格各行的总高度上限，行数较多时行高随之减小，表格仍在一页以内
+
+    // 表格的行列数由执勤地点与仪式登记表决定
+    int days; // 工作日数，每天一列
+    int timeRows; // 执勤时间表的行数
+    int dayWidth; // 每天一列的列宽
+    int rowHeight; // 表格行高
+
+    // 一张执勤表
+    struct Sheet {
+        QString filename; // 文件名，队员为“姓名_队员编号.pdf”（姓名中不能用于文件名的字符替换为“_”）
+        QString title; // 标题
+        QString subtitle; // 副标题，日期范围与组别
+        QString footer; // 表格下方的说明
+        std::vector<QString> cells; // 各单元格的文字，按（行，星期）排列
+        int duties = 0; // 执勤次数（人次）
+    };
+    // 各处使用的字体，只创建一次
+    struct Fonts {
+        QFont title;
+        QFont subtitle;
+        QFont header;
+        QFont cell;
+    };
+
+    Fonts fonts; // 字体
+    QByteArray frameData; // 录制好的表头、行标题与网格线（QPicture的指令数据），所有执勤表共用
+    std::vector<Sheet> sheets; // 全部执勤表，各组在前，队员按首次执勤的顺序在后
+
+    int cellIndex(int timeRow, int dayIndex) const { return (timeRow - 1) * days + dayIndex; }
+    QRect cellRect(int timeRow, int dayIndex) const {
+        return QRect(margin + labelWidth + dayIndex * dayWidth, tableTop + headerHeight + (timeRow - 1) * rowHeight, dayWidth, rowHeight);
+    }
+
+    // 字号以逻辑坐标的像素大小指定，回放QPicture时不会再按设备分辨率换算
+    void createFonts() {
+        fonts.title = QFont("黑体");
+        fonts.title.setPixelSize(110);
+        fonts.subtitle = QFont("等线");
+        fonts.subtitle.setPixelSize(60);
+        fonts.header = QFont("黑体");
+        fonts.header.setPixelSize(64);
+        fonts.cell = QFont("等线");
+        fonts.cell.setPixelSize(56);
+    }
+    // 录制表格框架：表头（星期）、行标题（地点与仪式）、网格线，配色与导出的Excel表格一致
+    void recordFrame(const SiteRegistry& registry) {
+        QPicture frame;
+        QPainter painter(&frame);
+        int tableWidth = labelWidth + days * dayWidth;
+        int tableHeight = headerHeight + timeRows * rowHeight;
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor("#FFC000"));
+        painter.drawRect(margin + labelWidth, tableTop, days * dayWidth, headerHeight);
+        painter.setBrush(QColor("#FFF000"));
+        painter.drawRect(margin, tableTop + headerHeight, labelWidth, timeRows * rowHeight);
+        painter.setPen(QPen(Qt::black, 3));
+        painter.setBrush(Qt::NoBrush);
+        painter.setFont(fonts.header);
+        for (int day = 0; day < days; ++day) {
+            QRect rect(margin + labelWidth + day * dayWidth, tableTop, dayWidth, headerHeight);
+            painter.drawText(rect, Qt::AlignCenter, registry.dayName(day));
+        }
+        for (int row = 1; row <= timeRows; ++row) {
+            QRect rect(margin, tableTop + headerHeight + (row - 1) * rowHeight, labelWidth, rowHeight);
+            painter.drawText(rect, Qt::AlignCenter, registry.rowLabel(row));
+        }
+        // 内部网格线
+        for (int day = 0; day <= days; ++day) {
+            int x = margin + labelWidth + day * dayWidth;
+            painter.drawLine(x, tableTop, x, tableTop + tableHeight);
+        }
+        for (int row = 0; row <= timeRows; ++row) {
+            int y = tableTop + headerHeight + row * rowHeight;
+            painter.drawLine(margin, y, margin + tableWidth, y);
+        }
+        // 粗外侧框线
+        painter.setPen(QPen(Qt::black, 8));
+        painter.drawRect(margin, tableTop, tableWidth, tableHeight);
+        painter.end();
+        frameData = QByteArray(frame.data(), static_cast<int>(frame.size()));
+    }
+    // 整理全部执勤表的内容：全部岗位只遍历一遍，每个执勤任务同时写入各执勤队员与其所在组的执勤表
+    void collectSheets(const SiteRegistry& registry, const DutyWeek& week) {
+        static const char* const groupNames[] = {"一组", "二组", "三组", "四组"};
+        QString dates = week.monday.toString("yyyy年M月d日") + " 至 "
+                        + week.monday.addDays(days - 1).toString("M月d日");
+        if (week.locations != registry.siteCount()
+            || week.seats.size() != static_cast<size_t>(registry.slotCount() * registry.siteCount() * ScheduleTable::peoplePerLocation)) {
+            return; // 排班结果与当前的执勤地点与仪式登记表不对应，不导出
+        }
+        std::array<Sheet, 4> groupSheets;
+        for (Sheet& sheet : groupSheets) {
+            sheet.cells.resize(timeRows * days);
+        }
+        std::vector<Sheet> memberSheets;
+        std::unordered_map<int, size_t> memberSheetOf; // 队员编号 -> 队员执勤表下标
+        for (int slot = 0; slot < registry.slotCount(); ++slot) {
+            int day = registry.slotDay(slot) - 1;
+            for (int location = 0; location < registry.siteCount(); ++location) {
+                int cell = cellIndex(registry.timeRow(slot, location), day);
+                QStringList crew;
+                for (int position = 0; position < ScheduleTable::peoplePerLocation; ++position) {
+                    const DutyWeek::Seat& seat = week.at(slot, location, position);
+                    if (seat.id != 0) {
+                        crew << seat.name;
+                    }
+                }
+                QString crewText = crew.join("\n");
+                for (int position = 0; position < ScheduleTable::peoplePerLocation; ++position) {
+                    const DutyWeek::Seat& seat = week.at(slot, location, position);
+                    if (seat.id == 0) {
+                        continue;
+                    }
+                    auto it = memberSheetOf.find(seat.id);
+                    if (it == memberSheetOf.end()) {
+                        Sheet sheet;
+                        sheet.cells.resize(timeRows * days);
+                        sheet.filename = QString("%1_%2.pdf").arg(FlagGroupFileManager::safeFileName(seat.name)).arg(seat.id);
+                        sheet.title = seat.name + " 的执勤安排";
+                        sheet.subtitle = dates + (seat.group >= 1 && seat.group <= 4 ? QString("　") + groupNames[seat.group - 1] : QString());
+                        it = memberSheetOf.emplace(seat.id, memberSheets.size()).first;
+                        memberSheets.push_back(std::move(sheet));
+                    }
+                    Sheet& memberSheet = memberSheets[it->second];
+                    memberSheet.cells[cell] = crewText; // 列出同一任务的全部执勤队员，方便交接
+                    ++memberSheet.duties;
+                    if (seat.group >= 1 && seat.group <= 4) {
+                        Sheet& groupSheet = groupSheets[seat.group - 1];
+                        groupSheet.cells[cell] += (groupSheet.cells[cell].isEmpty() ? "" : "\n") + seat.name;
+                        ++groupSheet.duties;
+                    }
+                }
+            }
+        }
+        for (int group = 0; group < 4; ++group) {
+            Sheet& sheet = groupSheets[group];
+            if (sheet.duties == 0) {
+                continue; // 本周没有执勤任务的组不导出
+            }
+            sheet.filename = QString(groupNames[group]) + "执勤表.pdf";
+            sheet.title = QString(groupNames[group]) + " 执勤安排";
+            sheet.subtitle = dates;
+            sheet.footer = QString("本组本周共 %1 人次执勤").arg(sheet.duties);
+            sheets.push_back(std::move(sheet));
+        }
+        for (Sheet& sheet : memberSheets) {
+            sheet.footer = QString("本周共执勤 %1 次，请提前到岗").arg(sheet.duties);
+            sheets.push_back(std::move(sheet));
+        }
+    }
+    // 绘制一张执勤表，在线程池的工作线程中执行
+    bool renderSheet(const Sheet& sheet, const QString& filename) const {
+        QPdfWriter writer(filename);
+        writer.setPageSize(QPageSize(QPageSize::A4));
+        writer.setPageOrientation(QPageLayout::Landscape);
+        writer.setPageMargins(QMarginsF(0, 0, 0, 0));
+        writer.setResolution(300);
+        writer.setTitle(sheet.title);
+        QPainter painter;
+        if (!painter.begin(&writer)) {
+            return false;
+        }
+        painter.setWindow(0, 0, pageWidth, pageHeight);
+        painter.setViewport(0, 0, writer.width(), writer.height());
+        painter.setFont(fonts.title);
+        painter.drawText(QRect(margin, margin, pageWidth - 2 * margin, 150), Qt::AlignLeft | Qt::AlignVCenter, sheet.title);
+        painter.setFont(fonts.subtitle);
+        painter.drawText(QRect(margin, margin + 150, pageWidth - 2 * margin, 100), Qt::AlignLeft | Qt::AlignVCenter, sheet.subtitle);
+        // 有执勤任务的单元格先填底色，再回放框架，网格线画在底色之上
+        painter.setPen(Qt::NoPen);
+        painter.setBrush(QColor("#DDEBF7"));
+        for (int row = 1; row <= timeRows; ++row) {
+            for (int day = 0; day < days; ++day) {
+                if (!sheet.cells[cellIndex(row, day)].isEmpty()) {
+                    painter.drawRect(cellRect(row, day));
+                }
+            }
+        }
+        QPicture frame; // 本线程自己的一份框架
+        frame.setData(frameData.constData(), static_cast<uint>(frameData.size()));
+        painter.drawPicture(0, 0, frame);
+        painter.setPen(Qt::black);
+        painter.setFont(fonts.cell);
+        for (int row = 1; row <= timeRows; ++row) {
+            for (int day = 0; day < days; ++day) {
+                const QString& text = sheet.cells[cellIndex(row, day)];
+                if (!text.isEmpty()) {
+                    painter.drawText(cellRect(row, day).adjusted(10, 10, -10, -10), Qt::AlignCenter | Qt::TextWordWrap, text);
+                }
+            }
+        }
+        painter.setFont(fonts.subtitle);
+        int tableBottom = tableTop + headerHeight + timeRows * rowHeight;
+        painter.drawText(QRect(margin, tableBottom + 40, pageWidth - 2 * margin, 100), Qt::AlignLeft | Qt::AlignVCenter, sheet.footer);
+        return painter.end();
+    }
+};
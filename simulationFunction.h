@@ -0,0 +1,331 @@
+// simulationFunction.h头文件
+// 功能说明：假设分析WhatIfSimulator，找出排班中的关键队员与脆弱时间段
+// 关键队员：该队员退出，或某一天缺席，就会使某个时间段无法排满
+// 为每名参加排班的队员生成扰动场景（整周缺席、某一个工作日缺席），交给线程池并行检查，
+// 按造成缺口的多少对队员和时间段排序
+// 全部场景共用同一份只读的花名册视图RosterView，每个场景只记录相对于视图的变化（哪名队员、哪一天），不复制花名册
+//
+// 两种检查方式：
+// 可行性检查：一个时间段每个地点各需3人，同一队员同一时间段只能在一个地点。由霍尔定理，能排满当且仅当
+// 对任意一组地点，在其中至少一个地点有空的队员（同一人只算一次）不少于3 × 地点数。默认两个地点时即
+// 第一个地点不少于3人、第二个地点不少于3人、两个地点合计不少于6人。
+// 视图预先统计好每个时间段每组地点的人数，一个场景只需减去该队员的贡献，代价只与时间段数、地点组数有关
+// 重放排班：在场景对应的花名册上实际排一次班（固定种子），统计比原花名册多出的空岗。排班是贪心的，
+// 满足上述条件的时间段也可能留下空岗，重放可以发现这类问题；花名册写时复制，每个场景只复制被改动的那名队员
+
+#pragma once
+
+#include <QString>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <vector>
+#include <memory>
+#include <algorithm>
+#include "Flag_group.h"
+#include "dataFunction.h"
+#include "siteFunction.h"
+
+// WhatIfSimulator 类定义，关键队员假设分析
+class WhatIfSimulator
+{
+public:
+    static constexpr int wholeWeek = -1; // 场景中表示整周缺席（退出）的“日期”
+
+    // 检查方式
+    enum Mode {
+        FeasibilityCheck, // 可行性检查
+        ScheduleReplay // 重放排班
+    };
+    // 一个扰动场景，相对于花名册视图的变化
+    struct Scenario {
+        int member; // 缺席的队员，为视图中参加排班队员的下标
+        int day; // 缺席的日期，0起（默认0~4为周一至周五），wholeWeek为整周缺席
+    };
+    // 一名队员的分析结果
+    struct MemberRisk {
+        int id = 0; // 队员编号
+        QString name; // 姓名
+        int group = 0; // 组别
+        int breakingScenarios = 0; // 该队员的场景中使某个时间段排不满的场景数
+        int brokenSlots = 0; // 这些场景合计排不满的时间段数
+        QStringList findings; // 每个排不满的场景一行说明
+    };
+    // 一个时间段的分析结果
+    struct SlotRisk {
+        int slot = 0; // 时间段，默认0~9
+        int criticalMembers = 0; // 缺席（整周或当天）会使该时间段排不满的队员数
+        int slack = 0; // 可行性余量：各组地点的人数减去所需人数中的最小值，为0时再少一人就可能排不满；已排不满时为缺口的相反数
+    };
+    // 分析结果
+    struct Report {
+        int scenarios = 0; // 检查的场景数
+        std::vector<int> baselineBroken; // 不做任何扰动时已经排不满的时间段
+        std::vector<MemberRisk> members; // 关键队员，按影响从大到小排列，不含不影响排班的队员
+        std::vector<SlotRisk> slotRisks; // 全部时间段，按脆弱程度从高到低排列
+    };
+
+    // 构造函数
+    // 参数：Flag_group：要分析的花名册，复制一份快照（写时复制，只复制队员指针），之后的分析不受原花名册修改影响
+    // 其余参数与SchedulingManager相同，重放排班时使用
+    WhatIfSimulator(const Flag_group& flagGroup, bool useTotalTimesRule = false,
+                    SchedulingManager::HandoverRule handoverRule = SchedulingManager::NoRule,
+                    const SiteRegistry& registry = SiteRegistry::defaults(), quint64 seed = 0)
+        : view(std::make_shared<const RosterView>(flagGroup, registry)), useTotalTimesRule(useTotalTimesRule),
+          handoverRule(handoverRule), registry(registry), seed(seed) {}
+
+    // 生成全部场景并在线程池中并行检查
+    // 参数：Mode：检查方式。QThreadPool：执行检查的线程池，默认为全局线程池（线程数等于CPU核数）
+    Report analyze(Mode mode = FeasibilityCheck, QThreadPool* pool = QThreadPool::globalInstance()) const {
+        std::vector<Scenario> scenarios;
+        for (int member = 0; member < static_cast<int>(view->members.size()); ++member) {
+            scenarios.push_back({member, wholeWeek});
+            for (int day = 0; day < registry.dayCount(); ++day) {
+                if (view->masks[member] & dayMask(day)) { // 这一天本来就没空的队员，缺席不改变任何情况
+                    scenarios.push_back({member, day});
+                }
+            }
+        }
+        // 不做扰动的基准情况
+        Outcome baseline = mode == FeasibilityCheck ? checkFeasibility(nullptr) : replaySchedule(nullptr);
+        // 每个场景一个任务，结果按场景下标写入，任务之间不共享可写数据
+        std::vector<Outcome> outcomes(scenarios.size());
+        std::vector<int> indexes(scenarios.size());
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            indexes[i] = static_cast<int>(i);
+        }
+        QtConcurrent::blockingMap(pool, indexes, [&](int index) {
+            outcomes[index] = mode == FeasibilityCheck ? checkFeasibility(&scenarios[index]) : replaySchedule(&scenarios[index]);
+        });
+        return summarize(scenarios, baseline, outcomes);
+    }
+
+    // 分析结果的文本报告
+    QString format(const Report& report) const {
+        QString text = QString("共检查 %1 个场景\n").arg(report.scenarios);
+        if (!report.baselineBroken.empty()) {
+            QStringList labels;
+            for (int slot : report.baselineBroken) {
+                labels << slotLabel(slot);
+            }
+            text += "不做任何假设时已经排不满：" + labels.join("、") + "\n";
+        }
+        text += "\n【关键队员】\n";
+        if (report.members.empty()) {
+            text += "没有关键队员：任何一名队员退出或某一天缺席都不会使时间段排不满\n";
+        }
+        for (const MemberRisk& risk : report.members) {
+            text += QString("%1（%2组）：%3 个场景排不满，合计 %4 个时间段\n").arg(risk.name).arg(risk.group)
+                        .arg(risk.breakingScenarios).arg(risk.brokenSlots);
+            for (const QString& finding : risk.findings) {
+                text += "    " + finding + "\n";
+            }
+        }
+        text += "\n【时间段】\n";
+        for (const SlotRisk& risk : report.slotRisks) {
+            text += QString("%1：关键队员 %2 人，余量 %3\n").arg(slotLabel(risk.slot)).arg(risk.criticalMembers).arg(risk.slack);
+        }
+        return text;
+    }
+
+private:
+    // 只读的花名册视图，全部场景共用，构造后不再修改，可在多个线程中同时读取
+    struct RosterView {
+        Flag_group roster; // 花名册快照，重放排班时在它的副本上施加变化
+        std::vector<const Person*> members; // 参加排班的队员，指向快照中的队员
+        std::vector<std::pair<int, int>> positions; // 各队员在快照中的位置（组别，组内行号）
+        std::vector<quint64> masks; // 各队员的执勤时间，与Person::getTimeBits相同
+        std::vector<std::vector<int>> bits; // 各时间段每个地点对应的执勤时间位
+        std::vector<std::vector<int>> counts; // 各时间段每组地点有空的人数（去重），按地点组的位掩码下标，0号不用
+        std::vector<int> needs; // 每组地点所需的人数：3 × 地点数
+
+        RosterView(const Flag_group& flagGroup, const SiteRegistry& registry) : roster(flagGroup) {
+            for (int group = 1; group <= 4; ++group) {
+                const auto& groupMembers = roster.getGroupMembers(group);
+                for (size_t row = 0; row < groupMembers.size(); ++row) {
+                    const Person& member = groupMembers[row];
+                    if (!member.getIsWork()) {
+                        continue;
+                    }
+                    members.push_back(&member);
+                    positions.push_back({group, static_cast<int>(row)});
+                    masks.push_back(member.getTimeBits());
+                }
+            }
+            const int subsets = 1 << registry.siteCount();
+            needs.assign(subsets, 0);
+            for (int subset = 1; subset < subsets; ++subset) {
+                needs[subset] = needs[subset & (subset - 1)] + ScheduleTable::peoplePerLocation; // 比去掉编号最小的地点后的地点组多一个地点
+            }
+            bits.assign(registry.slotCount(), std::vector<int>(registry.siteCount()));
+            counts.assign(registry.slotCount(), std::vector<int>(subsets, 0));
+            for (int slot = 0; slot < registry.slotCount(); ++slot) {
+                int day = registry.slotDay(slot);
+                for (int location = 0; location < registry.siteCount(); ++location) {
+                    bits[slot][location] = bitOf(registry.timeRow(slot, location), day);
+                }
+                for (quint64 mask : masks) {
+                    int available = availableSites(mask, bits[slot]);
+                    for (int subset = 1; subset < subsets; ++subset) {
+                        counts[slot][subset] += (available & subset) != 0;
+                    }
+                }
+            }
+        }
+    };
+    // 一个场景的检查结果
+    struct Outcome {
+        std::vector<int> shortage; // 各时间段的缺口，为0表示能排满
+    };
+
+    std::shared_ptr<const RosterView> view; // 花名册视图
+    bool useTotalTimesRule; // 重放排班时是否采用总次数规则
+    SchedulingManager::HandoverRule handoverRule; // 重放排班时的交接规则
+    const SiteRegistry& registry; // 执勤地点与仪式登记表
+    quint64 seed; // 重放排班的随机数种子，各场景相同，结果之间的差异只来自场景本身
+
+    static int bitOf(int timeRow, int day) { return (timeRow - 1) * Person::maxDays + (day - 1); }
+    // 执勤时间mask在哪些地点有空，返回地点组的位掩码
+    static int availableSites(quint64 mask, const std::vector<int>& siteBits) {
+        int available = 0;
+        for (size_t location = 0; location < siteBits.size(); ++location) {
+            available |= static_cast<int>(mask >> siteBits[location] & 1u) << location;
+        }
+        return available;
+    }
+    // 某一天（0起）全部执勤时间的位
+    quint64 dayMask(int day) const {
+        quint64 mask = 0;
+        for (int timeRow = 1; timeRow <= registry.timeRowCount(); ++timeRow) {
+            mask |= quint64(1) << bitOf(timeRow, day + 1);
+        }
+        return mask;
+    }
+    QString slotLabel(int slot) const {
+        return registry.dayName(registry.slotDay(slot) - 1) + " " + registry.ceremony(registry.slotHalfDay(slot)).name;
+    }
+
+    // 可行性检查：在视图的人数上减去场景中缺席队员失去的执勤时间
+    // scenario：为nullptr时检查不做扰动的基准情况
+    Outcome checkFeasibility(const Scenario* scenario) const {
+        Outcome outcome;
+        outcome.shortage.assign(registry.slotCount(), 0);
+        quint64 before = 0;
+        quint64 after = 0;
+        if (scenario) {
+            before = view->masks[scenario->member];
+            after = scenario->day == wholeWeek ? 0 : before & ~dayMask(scenario->day);
+        }
+        for (int slot = 0; slot < registry.slotCount(); ++slot) {
+            const std::vector<int>& counts = view->counts[slot];
+            int availableBefore = availableSites(before, view->bits[slot]);
+            int availableAfter = availableSites(after, view->bits[slot]);
+            int shortage = 0;
+            for (int subset = 1; subset < static_cast<int>(counts.size()); ++subset) {
+                int count = counts[subset] - ((availableBefore & subset) != 0) + ((availableAfter & subset) != 0);
+                shortage = std::max(shortage, view->needs[subset] - count);
+            }
+            outcome.shortage[slot] = shortage;
+        }
+        return outcome;
+    }
+    // 重放排班：复制快照（只复制队员指针），只修改缺席的那名队员，再排一次班并统计各时间段的空岗
+    Outcome replaySchedule(const Scenario* scenario) const {
+        Flag_group roster = view->roster;
+        if (scenario) {
+            const auto& position = view->positions[scenario->member];
+            Person& member = roster.getGroupMembers(position.first)[position.second];
+            if (scenario->day == wholeWeek) {
+                member.setIsWork(false);
+            } else {
+                for (int timeRow = 1; timeRow <= registry.timeRowCount(); ++timeRow) {
+                    member.setTime(timeRow, scenario->day + 1, false);
+                }
+            }
+        }
+        SchedulingManager manager(roster, useTotalTimesRule, handoverRule, registry);
+        manager.setSeed(seed);
+        manager.setCacheEnabled(false); // 场景结果只用一次，不挤占排班结果缓存
+        manager.schedule();
+        Outcome outcome;
+        const ScheduleTable& table = manager.getScheduleTable();
+        outcome.shortage.assign(table.slotCount(), 0);
+        for (int slot = 0; slot < table.slotCount(); ++slot) {
+            for (Person* person : table.slotSeats(slot)) {
+                outcome.shortage[slot] += person ? 0 : 1;
+            }
+        }
+        return outcome;
+    }
+
+    // 汇总各场景的结果：只计入比基准情况多出的缺口
+    Report summarize(const std::vector<Scenario>& scenarios, const Outcome& baseline, const std::vector<Outcome>& outcomes) const {
+        Report report;
+        report.scenarios = static_cast<int>(scenarios.size());
+        for (int slot = 0; slot < registry.slotCount(); ++slot) {
+            if (baseline.shortage[slot] > 0) {
+                report.baselineBroken.push_back(slot);
+            }
+        }
+        std::vector<MemberRisk> risks(view->members.size());
+        std::vector<std::vector<bool>> critical(view->members.size(), std::vector<bool>(registry.slotCount(), false));
+        for (size_t i = 0; i < scenarios.size(); ++i) {
+            const Scenario& scenario = scenarios[i];
+            QStringList broken;
+            for (int slot = 0; slot < registry.slotCount(); ++slot) {
+                if (outcomes[i].shortage[slot] > baseline.shortage[slot]) {
+                    broken << slotLabel(slot);
+                    critical[scenario.member][slot] = true;
+                }
+            }
+            if (broken.isEmpty()) {
+                continue;
+            }
+            MemberRisk& risk = risks[scenario.member];
+            risk.breakingScenarios++;
+            risk.brokenSlots += broken.size();
+            QString when = scenario.day == wholeWeek ? QString("整周缺席") : registry.dayName(scenario.day) + "缺席";
+            risk.findings << when + "：" + broken.join("、") + " 排不满";
+        }
+        for (size_t member = 0; member < risks.size(); ++member) {
+            if (risks[member].breakingScenarios == 0) {
+                continue;
+            }
+            const Person* person = view->members[member];
+            risks[member].id = person->getId();
+            risks[member].name = QString::fromStdString(person->getName());
+            risks[member].group = person->getGroup();
+            report.members.push_back(risks[member]);
+        }
+        std::stable_sort(report.members.begin(), report.members.end(), [](const MemberRisk& a, const MemberRisk& b) {
+            if (a.brokenSlots != b.brokenSlots) {
+                return a.brokenSlots > b.brokenSlots;
+            }
+            return a.breakingScenarios > b.breakingScenarios;
+        });
+        Outcome unperturbed = checkFeasibility(nullptr);
+        for (int slot = 0; slot < registry.slotCount(); ++slot) {
+            SlotRisk risk;
+            risk.slot = slot;
+            for (const auto& flags : critical) {
+                risk.criticalMembers += flags[slot];
+            }
+            const std::vector<int>& counts = view->counts[slot];
+            risk.slack = -unperturbed.shortage[slot];
+            if (unperturbed.shortage[slot] == 0) {
+                risk.slack = counts.size() > 1 ? counts[1] - view->needs[1] : 0;
+                for (int subset = 2; subset < static_cast<int>(counts.size()); ++subset) {
+                    risk.slack = std::min(risk.slack, counts[subset] - view->needs[subset]);
+                }
+            }
+            report.slotRisks.push_back(risk);
+        }
+        std::stable_sort(report.slotRisks.begin(), report.slotRisks.end(), [](const SlotRisk& a, const SlotRisk& b) {
+            if (a.criticalMembers != b.criticalMembers) {
+                return a.criticalMembers > b.criticalMembers;
+            }
+            return a.slack < b.slack;
+        });
+        return report;
+    }
+};
@@ -0,0 +1,199 @@
+// siteFunction.h头文件
+// 功能说明：执勤地点与仪式登记表SiteRegistry，启动时从配置文件读取
+// 地点的代码与名称、仪式（升旗、降旗）的名称与时间、星期的名称都由配置文件给出，不再在排班和界面代码中各写一份
+// 读取后一次性算出时间段、地点到星期、仪式、time数组行号以及各类显示文字的对照表，排班与界面直接按下标查表
+
+// 配置文件格式（每行一项，“#”开头为注释），未提供配置文件时使用与下面相同的默认值：
+// S|NJH|南鉴湖                   地点：代码|名称，按地点编号（location）顺序排列
+// C|升旗|上午|07:00|30           仪式：名称|时段名|开始时间|时长（分钟），按时段（halfDay）顺序排列
+// D|周一                         星期：名称，按工作日顺序排列，第一项为周一
+// 地点数、仪式数、工作日数都由配置文件决定，如增加一个校区或周末的仪式只需修改配置文件；某一类一项也没有给出时保持原有值
+// 队员执勤时间表的每一行对应一个（仪式，地点），每一列对应一个工作日，因此地点数 × 仪式数不超过Person::maxTimeRows，
+// 工作日数不超过Person::maxDays，超出时配置无效
+
+#pragma once
+
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QTime>
+#include <QDebug>
+#include <string>
+#include <vector>
+#include "Person.h"
+
+// SiteRegistry 类定义，执勤地点与仪式登记表
+class SiteRegistry
+{
+public:
+    static constexpr int maxTimeRows = Person::maxTimeRows; // 地点数 × 仪式数的上限
+    static constexpr int maxDays = Person::maxDays; // 工作日数的上限
+    static constexpr int maxCrews = maxDays * maxTimeRows; // （时间段，地点）组合数的上限，时间段数 × 地点数 = 工作日数 × 执勤时间表行数
+
+    // 执勤地点
+    struct Site {
+        QString code; // 代码，用于警告信息，如NJH
+        QString name; // 名称，如南鉴湖
+    };
+    // 仪式
+    struct Ceremony {
+        QString name; // 名称，如升旗
+        QString halfDayName; // 时段名，如上午
+        QTime start; // 开始时间
+        int minutes; // 时长（分钟）
+    };
+
+    // 默认登记表：南鉴湖、东西院两个地点，周一至周五每天升旗、降旗
+    SiteRegistry() {
+        sites = {{"NJH", "南鉴湖"}, {"DXY", "东西院"}};
+        ceremonies = {{"升旗", "上午", QTime(7, 0), 30}, {"降旗", "下午", QTime(18, 0), 30}};
+        dayNames = {"周一", "周二", "周三", "周四", "周五"};
+        buildTables();
+    }
+    // 未读取配置文件时使用的默认登记表
+    static const SiteRegistry& defaults() {
+        static const SiteRegistry registry;
+        return registry;
+    }
+
+    // 读取配置文件，文件不存在时保持默认值；内容有误时输出警告并保持原有登记表，返回是否读取成功
+    bool load(const QString& filename) {
+        QFile file(filename);
+        if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            return false;
+        }
+        std::vector<Site> newSites;
+        std::vector<Ceremony> newCeremonies;
+        std::vector<QString> newDays;
+        QTextStream in(&file);
+        while (!in.atEnd()) {
+            QString line = in.readLine().trimmed();
+            if (line.isEmpty() || line.startsWith('#')) {
+                continue;
+            }
+            QStringList parts = line.split("|");
+            if (parts[0] == "S" && parts.size() == 3) {
+                newSites.push_back({parts[1], parts[2]});
+            } else if (parts[0] == "C" && parts.size() == 5) {
+                newCeremonies.push_back({parts[1], parts[2], QTime::fromString(parts[3], "HH:mm"), parts[4].toInt()});
+            } else if (parts[0] == "D" && parts.size() == 2) {
+                newDays.push_back(parts[1]);
+            } else {
+                qWarning() << "地点配置文件" << filename << "中无法识别的行：" << line;
+                return false;
+            }
+        }
+        file.close();
+        // 没有给出的一类保持原有值
+        if (newSites.empty()) {
+            newSites = sites;
+        }
+        if (newCeremonies.empty()) {
+            newCeremonies = ceremonies;
+        }
+        if (newDays.empty()) {
+            newDays = dayNames;
+        }
+        if (newSites.size() * newCeremonies.size() > static_cast<size_t>(maxTimeRows) || newDays.size() > static_cast<size_t>(maxDays)) {
+            qWarning() << "地点配置文件" << filename << "中地点数 × 仪式数不能超过" << maxTimeRows << "，工作日不能超过"
+                       << maxDays << "个，已使用默认配置";
+            return false;
+        }
+        for (const Ceremony& ceremony : newCeremonies) {
+            if (!ceremony.start.isValid() || ceremony.minutes <= 0) {
+                qWarning() << "地点配置文件" << filename << "中仪式" << ceremony.name << "的时间无效，已使用默认配置";
+                return false;
+            }
+        }
+        sites = std::move(newSites);
+        ceremonies = std::move(newCeremonies);
+        dayNames = std::move(newDays);
+        buildTables();
+        return true;
+    }
+
+    // 数量
+    int siteCount() const { return static_cast<int>(sites.size()); } // 执勤地点数，默认2个
+    int ceremonyCount() const { return static_cast<int>(ceremonies.size()); } // 每天的仪式数，默认2个
+    int dayCount() const { return static_cast<int>(dayNames.size()); } // 每周工作日数，默认5天
+    int slotCount() const { return dayCount() * ceremonyCount(); } // 每周时间段数，默认10个
+    int timeRowCount() const { return ceremonyCount() * siteCount(); } // 队员执勤时间表的行数，默认4行
+
+    // 登记表内容
+    const Site& site(int location) const { return sites[location]; }
+    const Ceremony& ceremony(int halfDay) const { return ceremonies[halfDay]; }
+    const QString& dayName(int dayIndex) const { return dayNames[dayIndex]; } // dayIndex：0起
+    // 文字（如报名表表头）中是否写有该工作日，“周一”与“星期一”两种写法都可以
+    bool mentionsDay(const QString& text, int dayIndex) const {
+        const QString& name = dayNames[dayIndex];
+        if (text.contains(name)) {
+            return true;
+        }
+        if (name.startsWith("周")) {
+            return text.contains("星期" + name.mid(1));
+        }
+        if (name.startsWith("星期")) {
+            return text.contains("周" + name.mid(2));
+        }
+        return false;
+    }
+
+    // 对照表
+    // slot：0起，时间段。location：0起，地点。timeRow：1起，队员执勤时间表的行
+    int slotDay(int slot) const { return slotDays[slot]; } // 时间段对应的星期，1起，与Person::getTime的列一致
+    int slotHalfDay(int slot) const { return slotHalfDays[slot]; } // 时间段对应的仪式，0起
+    int timeRow(int slot, int location) const { return timeRows[slot * siteCount() + location]; }
+    // 时间段、地点的说明文字，如“周一 上午 NJH”，用于排班警告
+    const std::string& crewLabel(int slot, int location) const { return crewLabels[slot * siteCount() + location]; }
+    // 执勤时间表每一行的名称，如“南鉴湖升旗”，用于工作表格行标题
+    const QString& rowLabel(int timeRow) const { return rowLabels[timeRow - 1]; }
+    // 执勤时间表某一行对应的地点与仪式
+    int rowLocation(int timeRow) const { return (timeRow - 1) % siteCount(); }
+    int rowHalfDay(int timeRow) const { return (timeRow - 1) / siteCount(); }
+    // 影响排班结果的全部登记表内容：各时间段的星期、各岗位对应的执勤时间表行与警告中的说明文字，用作排班结果缓存键的一部分
+    std::string signature() const {
+        std::string text = std::to_string(siteCount()) + '\x1f' + std::to_string(slotCount()) + '\x1e';
+        for (int slot = 0; slot < slotCount(); ++slot) {
+            text += std::to_string(slotDays[slot]) + '\x1f';
+            for (int location = 0; location < siteCount(); ++location) {
+                text += std::to_string(timeRow(slot, location)) + '\x1f' + crewLabel(slot, location) + '\x1f';
+            }
+        }
+        return text;
+    }
+
+private:
+    std::vector<Site> sites; // 执勤地点
+    std::vector<Ceremony> ceremonies; // 仪式
+    std::vector<QString> dayNames; // 工作日名称
+    std::vector<int> slotDays; // 时间段 -> 星期
+    std::vector<int> slotHalfDays; // 时间段 -> 仪式
+    std::vector<int> timeRows; // （时间段，地点） -> 执勤时间表的行
+    std::vector<std::string> crewLabels; // （时间段，地点） -> 说明文字
+    std::vector<QString> rowLabels; // 执勤时间表的行 -> 名称
+
+    // 计算各对照表，登记表内容变化后调用
+    void buildTables() {
+        const int sitesPerSlot = siteCount();
+        const int ceremoniesPerDay = ceremonyCount();
+        slotDays.assign(slotCount(), 0);
+        slotHalfDays.assign(slotCount(), 0);
+        timeRows.assign(slotCount() * sitesPerSlot, 0);
+        crewLabels.assign(slotCount() * sitesPerSlot, std::string());
+        for (int slot = 0; slot < slotCount(); ++slot) {
+            int dayIndex = slot / ceremoniesPerDay;
+            int halfDay = slot % ceremoniesPerDay;
+            slotDays[slot] = dayIndex + 1;
+            slotHalfDays[slot] = halfDay;
+            for (int location = 0; location < sitesPerSlot; ++location) {
+                timeRows[slot * sitesPerSlot + location] = halfDay * sitesPerSlot + location + 1;
+                crewLabels[slot * sitesPerSlot + location] = (dayNames[dayIndex] + " " + ceremonies[halfDay].halfDayName + " "
+                                                              + sites[location].code).toStdString();
+            }
+        }
+        rowLabels.assign(timeRowCount(), QString());
+        for (int row = 0; row < timeRowCount(); ++row) {
+            rowLabels[row] = sites[row % sitesPerSlot].name + ceremonies[row / sitesPerSlot].name;
+        }
+    }
+};
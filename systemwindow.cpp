@@ -4,14 +4,22 @@
 
 #include "ui_systemwindow.h"
 #include <QMessageBox>
-#include <QStringListModel>
 #include <QCloseEvent>
 #include <QFileDialog>
 #include <QAxObject>
 #include <QProgressDialog>
+#include <QShortcut>
+#include <QSignalBlocker>
+#include <QTimer>
+#include <QCoreApplication>
+#include <QPromise>
+#include <QtConcurrent/QtConcurrent>
+#include <unordered_set>
 #include "systemwindow.h"
 #include "fileFunction.h"
 #include "dataFunction.h"
+#include "importFunction.h"
+#include "calendarFunction.h"
 
 SystemWindow::SystemWindow(QWidget *parent)
     : QMainWindow(parent) // 窗口
@@ -25,8 +33,12 @@ SystemWindow::SystemWindow(QWidget *parent)
     // 将“使用说明”界面的 QTextEdit 文本框设置为只读模式
     ui->instructionText->setReadOnly(true);
 
-    // 在窗口启动时读取文件
-    FlagGroupFileManager::loadFromFile(flagGroup, filename);
+    // 读取执勤地点与仪式配置，没有配置文件时使用默认的南鉴湖、东西院与升旗、降旗
+    siteRegistry.load("./data/sites.txt");
+    // 后台保存花名册，数据文件读取完成后开始定时保存
+    rosterSaver = new RosterSaver(flagGroup, filename, this);
+    // 读取执勤历史
+    history.load();
 
     // 执勤管理界面
     // 连接按钮和复选框的信号与槽
@@ -34,27 +46,36 @@ SystemWindow::SystemWindow(QWidget *parent)
     connect(ui->clearButton, &QPushButton::clicked, this, &SystemWindow::onClearButtonClicked); // 清空表格按钮点击事件
     connect(ui->alterButton, &QPushButton::clicked, this, &SystemWindow::onResetButtonClicked); // 重置队员执勤总次数按钮点击事件
     connect(ui->deriveButton, &QPushButton::clicked, this, &SystemWindow::onExportButtonClicked); // 导出表格按钮点击事件
-    connect(ui->times_rule, &QCheckBox::clicked, this, &SystemWindow::onTotalTimesRuleClicked); // 总次数规则按钮点击事件
-    // 连接单选按钮信号与槽
-    // 交接工作单选按钮点击事件
-    connect(ui->No_handover_rule_radioButton, &QRadioButton::clicked, this, &SystemWindow::onRadioButtonClicked); // 不采用交接规则
-    connect(ui->Monday_handover_rule_radioButton, &QRadioButton::clicked, this, &SystemWindow::onRadioButtonClicked); // 仅周二的南鉴湖升旗采用交接规则
-    connect(ui->All_handover_rule_radioButton, &QRadioButton::clicked, this, &SystemWindow::onRadioButtonClicked); // 全周（周二至周五）南鉴湖升旗采用交接规则
+    connect(ui->diffExportButton, &QPushButton::clicked, this, &SystemWindow::onDiffExportButtonClicked); // 导出排班变动按钮点击事件
+    connect(ui->calendarExportButton, &QPushButton::clicked, this, &SystemWindow::onCalendarExportButtonClicked); // 导出执勤日历按钮点击事件
+    connect(ui->sheetExportButton, &QPushButton::clicked, this, &SystemWindow::onSheetExportButtonClicked); // 导出执勤表PDF按钮点击事件
+    // 总次数规则与交接规则不必连接信号：每次点击制表时新建排班管理器，从这几个按钮读取规则，修改对下一次制表生效
     // 将不采用交接按钮默认设置为选定状态
     ui->No_handover_rule_radioButton->setChecked(true);
+    // 工作表格的行数、列数与行、列标题按登记表设置
+    QStringList rowLabels;
+    for (int row = 1; row <= siteRegistry.timeRowCount(); ++row) {
+        rowLabels << siteRegistry.rowLabel(row);
+    }
+    QStringList dayLabels;
+    for (int day = 0; day < siteRegistry.dayCount(); ++day) {
+        dayLabels << siteRegistry.dayName(day);
+    }
+    ui->worksheet->setRowCount(rowLabels.size());
+    ui->worksheet->setColumnCount(dayLabels.size());
+    ui->worksheet->setVerticalHeaderLabels(rowLabels);
+    ui->worksheet->setHorizontalHeaderLabels(dayLabels);
 
     // 队员管理界面
-    // 更新四个组的队员标签界面
-    for (int groupIndex = 1; groupIndex <= 4; ++groupIndex) {
-        updateListView(groupIndex);
-    }
-    // 将 FlagGroup 中所有队员的 iswork 信息全部调成 false，对应全组执勤按钮的未选定状态
-    for (int groupIndex = 1; groupIndex <= 4; ++groupIndex) {
-        auto& members = flagGroup.getGroupMembers(groupIndex); // 返回对应组的队员列表
-        for (auto& member : members) {
-            member.setIsWork(false); // 修改iswork信息
-        }
+    // 为四个组的队员标签界面绑定模型
+    setupListViews();
+    // 建立队员搜索索引，索引监听四个组的模型，随队员增删改自动更新
+    searchIndex = new MemberSearchIndex(flagGroup, this);
+    for (RosterListModel* model : listModels) {
+        searchIndex->attachModel(model);
     }
+    // 在窗口启动时读取文件，在后台读取，窗口不必等待整个文件读完才显示
+    startRosterLoading();
     // 设置 availableTime_groupBox 中除“全选”按钮外的按钮为 checkable
     QList<QAbstractButton*> buttons = ui->availableTime_groupBox->findChildren<QAbstractButton*>();
     for (QAbstractButton* button : buttons) {
@@ -104,29 +125,18 @@ SystemWindow::SystemWindow(QWidget *parent)
     connect(ui->birthday_lineEdit, &QLineEdit::editingFinished, this, &SystemWindow::onInfoLineEditChanged);
     connect(ui->gender_combobox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &SystemWindow::onInfoLineEditChanged);
 
-    // 连接出勤安排按钮的信号与槽
-    connect(ui->monday_up_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->monday_up_NJH_pushButton);});
-    connect(ui->monday_up_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->monday_up_DXY_pushButton);});
-    connect(ui->tuesday_up_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->tuesday_up_NJH_pushButton);});
-    connect(ui->tuesday_up_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->tuesday_up_DXY_pushButton);});
-    connect(ui->wednesday_up_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->wednesday_up_NJH_pushButton);});
-    connect(ui->wednesday_up_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->wednesday_up_DXY_pushButton);});
-    connect(ui->thursday_up_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->thursday_up_NJH_pushButton);});
-    connect(ui->thursday_up_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->thursday_up_DXY_pushButton);});
-    connect(ui->friday_up_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->friday_up_NJH_pushButton);});
-    connect(ui->friday_up_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->friday_up_DXY_pushButton);});
-    connect(ui->monday_down_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->monday_down_NJH_pushButton);});
-    connect(ui->monday_down_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->monday_down_DXY_pushButton);});
-    connect(ui->tuesday_down_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->tuesday_down_NJH_pushButton);});
-    connect(ui->tuesday_down_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->tuesday_down_DXY_pushButton);});
-    connect(ui->wednesday_down_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->wednesday_down_NJH_pushButton);});
-    connect(ui->wednesday_down_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->wednesday_down_DXY_pushButton);});
-    connect(ui->thursday_down_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->thursday_down_NJH_pushButton);});
-    connect(ui->thursday_down_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->thursday_down_DXY_pushButton);});
-    connect(ui->friday_down_NJH_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->friday_down_NJH_pushButton);});
-    connect(ui->friday_down_DXY_pushButton, &QPushButton::clicked, [this](bool) {onAttendanceButtonClicked(ui->friday_down_DXY_pushButton);});
+    // 按登记表建立出勤安排按钮对照表，并连接出勤安排按钮的信号与槽
+    setupAttendanceButtons();
     // 连接是否执勤按钮的信号与槽
     connect(ui->isWork_pushButton, &QPushButton::clicked, this, &SystemWindow::onIsWorkPushButtonClicked);
+    // 连接搜索队员栏的信号与槽
+    connect(ui->search_lineEdit, &QLineEdit::textChanged, this, &SystemWindow::onSearchTextChanged);
+    connect(ui->search_listWidget, &QListWidget::itemClicked, this, &SystemWindow::onSearchResultClicked);
+    // 连接批量导入栏的信号与槽
+    connect(ui->import_pushButton, &QPushButton::clicked, this, &SystemWindow::onImportButtonClicked);
+    // 撤销/重做快捷键
+    connect(new QShortcut(QKeySequence::Undo, this), &QShortcut::activated, this, &SystemWindow::onUndoTriggered);
+    connect(new QShortcut(QKeySequence::Redo, this), &QShortcut::activated, this, &SystemWindow::onRedoTriggered);
 }
 SystemWindow::~SystemWindow()
 {
@@ -138,8 +148,19 @@ void SystemWindow::closeEvent(QCloseEvent *event)
     // 弹出提示窗口
     QMessageBox::StandardButton reply = QMessageBox::question(this, "关闭系统", "是否关闭系统？", QMessageBox::Yes | QMessageBox::No);
     if (reply == QMessageBox::Yes) {
-        // 保存文件
-        FlagGroupFileManager::saveToFile(flagGroup, filename);
+        // 正在后台排班时等待排班完成，处理排队中的警告信号，再直接完成收尾，把执勤次数写回花名册
+        if (schedulingWatcher) {
+            schedulingWatcher->waitForFinished();
+            QCoreApplication::sendPostedEvents(this, QEvent::MetaCall);
+            finishScheduling();
+        }
+        // 数据文件尚未读完时先读完，否则只会保存读出的部分队员
+        if (rosterLoader) {
+            rosterLoader->waitForFinished();
+            finishRosterLoading();
+        }
+        // 保存文件，等待正在进行的后台保存完成后保存剩余的修改
+        rosterSaver->flush();
         // 接受关闭事件
         event->accept();
     } else {
@@ -151,6 +172,7 @@ void SystemWindow::closeEvent(QCloseEvent *event)
 //值周管理界面函数实现
 void SystemWindow::onTabulateButtonClicked() {
     // 制表按钮
+    TraceScope trace("SystemWindow::onTabulateButtonClicked", "slot");
     if (!manager) {
         bool useTotalTimesRule = ui->times_rule->isChecked();
         SchedulingManager::HandoverRule handoverRule = SchedulingManager::NoRule;
@@ -159,35 +181,73 @@ void SystemWindow::onTabulateButtonClicked() {
         } else if (ui->All_handover_rule_radioButton->isChecked()) {
             handoverRule = SchedulingManager::AllHandoverRule;
         }
-        manager = new SchedulingManager(flagGroup, useTotalTimesRule, handoverRule);
+        // 排班管理器复制一份花名册快照，在后台线程中排班，排班期间界面仍可修改花名册
+        manager = new SchedulingManager(flagGroup, useTotalTimesRule, handoverRule, siteRegistry);
+        // 用户要求固定结果时，以所排那一周作为随机数种子：同一周内花名册与规则未变时重复制表直接得到缓存的结果；
+        // 否则每次制表重新随机排班，不满意时可以再点一次
+        if (ui->fixed_seed_checkBox->isChecked()) {
+            manager->setSeed(static_cast<quint64>(scheduledWeekMonday().toJulianDay()));
+        }
         connect(manager, &SchedulingManager::schedulingWarning, this, &SystemWindow::handleSchedulingWarning);  // 连接警告信号与发送警告信息的槽函数
-        connect(manager, &SchedulingManager::schedulingFinished, [this]() {
-            updateTableWidget(*manager); // 制表操作
-            updateTextEdit(*manager); // 更新制表结果文本域
-            delete manager;
-            manager = nullptr;
-        });
     }
-    manager->schedule();
+    ui->tabulateButton->setEnabled(false); // 排班完成前不能再次制表
+    SchedulingManager* running = manager;
+    schedulingTask = QtConcurrent::run([running]() { running->schedule(); });
+    // 由后台任务本身的结束驱动收尾：schedulingFinished信号在工作线程中发出，排队的槽函数开始执行时
+    // 工作线程可能还没有从emit中返回，此时删除管理器会与工作线程冲突；任务结束后工作线程已不再访问管理器
+    schedulingWatcher = new QFutureWatcher<void>(this);
+    connect(schedulingWatcher, &QFutureWatcher<void>::finished, this, &SystemWindow::finishScheduling);
+    schedulingWatcher->setFuture(schedulingTask);
+}
+void SystemWindow::finishScheduling()
+{
+    // 排班完成后的收尾，在界面线程中执行
+    TraceScope trace("SystemWindow::finishScheduling", "slot");
+    if (!schedulingWatcher) {
+        return; // 关闭窗口时已直接完成
+    }
+    schedulingWatcher->deleteLater();
+    schedulingWatcher = nullptr;
+    // 保存到执勤历史，同一周重新制表时历史文件中该周只保留最后一次
+    ScheduleHistory::WeekChange weekChange = history.commitWeek(scheduledWeekMonday(), manager->getScheduleTable());
+    // 写回执勤次数前记下全部队员（排班期间界面中仍可修改谁参加排班），撤销本次制表时一并撤销历史中的这一周
+    undoStack.recordAll(flagGroup, [this, weekChange](bool redo) {
+        redo ? history.redoWeek(weekChange) : history.undoWeek(weekChange);
+    });
+    manager->commitDutyCounts(flagGroup); // 在界面线程中一次写回全部执勤次数
+    // 与上一次排班结果比较
+    ScheduleSnapshot snapshot = ScheduleSnapshot::of(manager->getScheduleTable(), memberHandles);
+    scheduleDiff = lastSchedule.valid ? ScheduleDiff::compute(lastSchedule, snapshot) : ScheduleDiff();
+    lastSchedule = snapshot;
+    lastDutyWeek = DutyWeek::of(manager->getScheduleTable(), scheduledWeekMonday());
+    updateTableWidget(*manager); // 制表操作
+    updateTextEdit(*manager); // 更新制表结果文本域
+    delete manager;
+    manager = nullptr;
+    ui->tabulateButton->setEnabled(true);
 }
 void SystemWindow::updateTableWidget(const SchedulingManager& manager) {
     //制表操作，点击制表按钮后的辅助函数
+    TraceScope trace("SystemWindow::updateTableWidget", "ui");
     const auto& scheduleTable = manager.getScheduleTable();
     // 从周一上午开始，依次处理表格每个时间槽（周一上午、周一下午、周二上午、周二下午…… 周五下午）
-    for (int slot = 0; slot < 10; ++slot) {
-        int day = slot / 2; // 0~4，分别对应周一至周五
-        int halfDay = slot % 2; // 时段，0~1，分别对应升旗与降旗
-        for (int location = 0; location < 2; ++location) {
-            // 对于每个时间槽，依次处理两个地点。
-            int row = halfDay * 2 + location;// 表格对应的行数，0~3，对应表格单元项的第一到第四行（即不包括表头）
+    for (int slot = 0; slot < scheduleTable.slotCount(); ++slot) {
+        int day = siteRegistry.slotDay(slot) - 1; // 默认0~4，分别对应周一至周五
+        for (int location = 0; location < scheduleTable.siteCount(); ++location) {
+            // 对于每个时间槽，依次处理各个地点。
+            int row = siteRegistry.timeRow(slot, location) - 1;// 表格对应的行数，默认0~3，对应表格单元项的第一到第四行（即不包括表头）
             QString cellText;
-            for (int position = 0; position < 3; ++position) {
+            for (int position = 0; position < ScheduleTable::peoplePerLocation; ++position) {
                 // 对于每个地点，检查并添加 3 个人员位置的人员姓名。
-                if (scheduleTable[slot][location][position]) {
-                    cellText += QString::fromStdString(scheduleTable[slot][location][position]->getName()) + " ";
+                if (Person* person = scheduleTable.at(slot, location, position)) {
+                    cellText += QString::fromStdString(person->getName()) + " ";
                 }
             }
-            ui->worksheet->setItem(row, day, new QTableWidgetItem(cellText.trimmed()));
+            QTableWidgetItem* item = new QTableWidgetItem(cellText.trimmed());
+            if (scheduleDiff.crewChanged(slot, location)) {
+                item->setBackground(QColor("#FFE699")); // 与上一次排班相比有变化的任务
+            }
+            ui->worksheet->setItem(row, day, item);
         }
     }
 
@@ -261,6 +321,14 @@ void SystemWindow::updateTableWidget(const SchedulingManager& manager) {
     }
 
 }
+QDate SystemWindow::scheduledWeekMonday()
+{
+    // 本次排班对应那一周的周一
+    // 周一至周五排班视为排本周，周六、周日排班视为排下一周
+    QDate today = QDate::currentDate();
+    QDate monday = today.addDays(1 - today.dayOfWeek());
+    return today.dayOfWeek() >= 6 ? monday.addDays(7) : monday;
+}
 void SystemWindow::handleSchedulingWarning(const QString& warningMessage)
 {
     // 排表过程出现无法选出合适人选时的情况，保存警告信息
@@ -269,12 +337,21 @@ void SystemWindow::handleSchedulingWarning(const QString& warningMessage)
 
 void SystemWindow::updateTextEdit(const SchedulingManager& manager) {
     // 制表结果文本域更新
+    TraceScope trace("SystemWindow::updateTextEdit", "ui");
     QString resultText;
     const auto& availableMembers = manager.getAvailableMembers();
     for (const auto& member : availableMembers) {
         resultText += QString::fromStdString(member->getName()) + " 的工作次数: " + QString::number(member->getTimes()) +
                       " 总工作次数: " + QString::number(member->getAll_times()) + "\n";
     }
+    // 与上一次排班相比的变动
+    if (scheduleDiff.isComputed()) {
+        if (scheduleDiff.isEmpty()) {
+            resultText += "\n与上一次排班相比没有变化\n";
+        } else {
+            resultText += "\n与上一次排班相比的变动（表格中已标出）：\n" + scheduleDiff.describe(memberHandles, siteRegistry).join("\n") + "\n";
+        }
+    }
     // 拼接警告信息和排班结果文本
     QString finalText = warningMessages + resultText;
     // 设置最终文本到文本编辑框
@@ -284,11 +361,14 @@ void SystemWindow::updateTextEdit(const SchedulingManager& manager) {
 }
 void SystemWindow::onClearButtonClicked() {
     //清空表格按钮
+    TraceScope trace("SystemWindow::onClearButtonClicked", "slot");
     ui->worksheet->clearContents();
     ui->timesResult->clear();
 }
 void SystemWindow::onResetButtonClicked() {
     //重置队员执勤次数按钮
+    TraceScope trace("SystemWindow::onResetButtonClicked", "slot");
+    undoStack.recordAll(flagGroup); // 归零前记下全部队员，误操作时可以撤销
     for (int i = 1; i < 5; ++i) {
         auto& allMembers = flagGroup.getGroupMembers(i);
         for (auto& member : allMembers) {
@@ -322,15 +402,18 @@ void SystemWindow::onExportButtonClicked()
             if (workbook) {
                 // 获取新工作簿的第一个工作表
                 QAxObject *worksheetExcel = workbook->querySubObject("Worksheets(int)", 1);
+                // 表格的区域随登记表变化，默认登记表为A1~G5：第一行为列标题，C列起每天一列，第二行起每个（仪式，地点）一行
+                const QString lastColumn = QString(QChar('C' + siteRegistry.dayCount() - 1)); // 最后一列，默认G
+                const int lastRow = 1 + siteRegistry.timeRowCount(); // 最后一行，默认5
                 // 1. 所有拥有文字的区域（A1~G5矩阵区域）都应该居中对齐
-                QAxObject *allRange = worksheetExcel->querySubObject("Range(const QString&)", "A1:G5");
+                QAxObject *allRange = worksheetExcel->querySubObject("Range(const QString&)", QString("A1:%1%2").arg(lastColumn).arg(lastRow));
                 QAxObject *allAlignment = allRange->querySubObject("HorizontalAlignment");
                 if (allAlignment) {
                     allAlignment->dynamicCall("SetValue(int)", -4108); // xlCenter
                     delete allAlignment;
                 }
                 // 2. 第一行列标题C1~G1区域，文本内容不变，字体格式改为16号黑体，背景填充色改为#FFC000
-                QAxObject *headerRange = worksheetExcel->querySubObject("Range(const QString&)", "C1:G1");
+                QAxObject *headerRange = worksheetExcel->querySubObject("Range(const QString&)", "C1:" + lastColumn + "1");
                 QAxObject *headerFont = headerRange->querySubObject("Font");
                 headerFont->dynamicCall("SetName(const QString&)", "黑体");
                 headerFont->dynamicCall("SetSize(int)", 16);
@@ -344,33 +427,28 @@ void SystemWindow::onExportButtonClicked()
                     QAxObject *cell = worksheetExcel->querySubObject("Cells(int,int)", 1, col + 3); // 从第一行第三列开始写列标题
                     cell->dynamicCall("SetValue(const QVariant&)", headerText);
                 }
-                // 3. 第一列A2和A3区域合并，并输入“升旗”文本，字体格式改为16号黑体，背景填充色改为#FFFF00
+                // 3、4. 第一列每个仪式占地点数行（默认A2和A3为“升旗”，A4和A5为“降旗”），区域合并并输入仪式名称，
+                // 字体格式改为16号黑体，背景填充色改为#FFFF00
                 // 两者使用的颜色单位不同，不能直接转换需要rgb to bgr的操作
-                QAxObject *riseFlagRange = worksheetExcel->querySubObject("Range(const QString&)", "A2:A3");
-                riseFlagRange->dynamicCall("Merge()");
-                QAxObject *riseFlagCell = worksheetExcel->querySubObject("Cells(int,int)", 2, 1);
-                riseFlagCell->dynamicCall("SetValue(const QVariant&)", "升旗");
-                QAxObject *riseFlagFont = riseFlagRange->querySubObject("Font");
-                riseFlagFont->dynamicCall("SetName(const QString&)", "黑体");
-                riseFlagFont->dynamicCall("SetSize(int)", 16);
-                QAxObject *riseFlagInterior = riseFlagRange->querySubObject("Interior");
-                Color = QColor("#FFF000");
-                BgrColor = rgbToBgr(Color);
-                riseFlagInterior->dynamicCall("SetColor(int)", BgrColor);
-                // 4. 第一列A4和A5区域合并，并输入“降旗”文本，字体格式改为16号黑体，背景填充色改为#FFFF00
-                QAxObject *lowerFlagRange = worksheetExcel->querySubObject("Range(const QString&)", "A4:A5");
-                lowerFlagRange->dynamicCall("Merge()");
-                QAxObject *lowerFlagCell = worksheetExcel->querySubObject("Cells(int,int)", 4, 1);
-                lowerFlagCell->dynamicCall("SetValue(const QVariant&)", "降旗");
-                QAxObject *lowerFlagFont = lowerFlagRange->querySubObject("Font");
-                lowerFlagFont->dynamicCall("SetName(const QString&)", "黑体");
-                lowerFlagFont->dynamicCall("SetSize(int)", 16);
-                QAxObject *lowerFlagInterior = lowerFlagRange->querySubObject("Interior");
-                Color = QColor("#FFF000");
-                BgrColor = rgbToBgr(Color);
-                lowerFlagInterior->dynamicCall("SetColor(int)", BgrColor);
+                std::vector<QAxObject*> ceremonyRanges;
+                for (int halfDay = 0; halfDay < siteRegistry.ceremonyCount(); ++halfDay) {
+                    int firstRow = 2 + halfDay * siteRegistry.siteCount();
+                    int endRow = firstRow + siteRegistry.siteCount() - 1;
+                    QAxObject *ceremonyRange = worksheetExcel->querySubObject("Range(const QString&)", QString("A%1:A%2").arg(firstRow).arg(endRow));
+                    ceremonyRange->dynamicCall("Merge()");
+                    QAxObject *ceremonyCell = worksheetExcel->querySubObject("Cells(int,int)", firstRow, 1);
+                    ceremonyCell->dynamicCall("SetValue(const QVariant&)", siteRegistry.ceremony(halfDay).name);
+                    QAxObject *ceremonyFont = ceremonyRange->querySubObject("Font");
+                    ceremonyFont->dynamicCall("SetName(const QString&)", "黑体");
+                    ceremonyFont->dynamicCall("SetSize(int)", 16);
+                    QAxObject *ceremonyInterior = ceremonyRange->querySubObject("Interior");
+                    Color = QColor("#FFF000");
+                    BgrColor = rgbToBgr(Color);
+                    ceremonyInterior->dynamicCall("SetColor(int)", BgrColor);
+                    ceremonyRanges.push_back(ceremonyRange);
+                }
                 // 5. 第二列B2~B5区域行标题，文本内容不变，字体格式改为12号等线，背景填充色改为#FFFF00
-                QAxObject *rowHeaderRange = worksheetExcel->querySubObject("Range(const QString&)", "B2:B5");
+                QAxObject *rowHeaderRange = worksheetExcel->querySubObject("Range(const QString&)", QString("B2:B%1").arg(lastRow));
                 QAxObject *rowHeaderFont = rowHeaderRange->querySubObject("Font");
                 rowHeaderFont->dynamicCall("SetName(const QString&)", "等线");
                 rowHeaderFont->dynamicCall("SetSize(int)", 12);
@@ -408,19 +486,19 @@ void SystemWindow::onExportButtonClicked()
                 headerBorders->dynamicCall("LineStyle", 1); // xlContinuous
                 QAxObject *rowHeaderBorders = rowHeaderRange->querySubObject("Borders");
                 rowHeaderBorders->dynamicCall("LineStyle", 1); // xlContinuous
-                QAxObject *riseFlagBorders = riseFlagRange->querySubObject("Borders");
-                riseFlagBorders->dynamicCall("LineStyle", 1); // xlContinuous
-                QAxObject *lowerFlagBorders = lowerFlagRange->querySubObject("Borders");
-                lowerFlagBorders->dynamicCall("LineStyle", 1); // xlContinuous
+                for (QAxObject *ceremonyRange : ceremonyRanges) {
+                    QAxObject *ceremonyBorders = ceremonyRange->querySubObject("Borders");
+                    ceremonyBorders->dynamicCall("LineStyle", 1); // xlContinuous
+                }
                 // 7. A列宽110像素，B列宽175像素，C~G列宽350像素，1~5行高全部设置为65像素
                 // 两者计量单位不同，需要计算后转换
                 QAxObject *columnA = worksheetExcel->querySubObject("Columns(const QString&)", "A");
                 columnA->dynamicCall("ColumnWidth", 8);
                 QAxObject *columnB = worksheetExcel->querySubObject("Columns(const QString&)", "B");
                 columnB->dynamicCall("ColumnWidth", 14);
-                QAxObject *columnsCToG = worksheetExcel->querySubObject("Range(const QString&)", "C:G");
+                QAxObject *columnsCToG = worksheetExcel->querySubObject("Range(const QString&)", "C:" + lastColumn);
                 columnsCToG->dynamicCall("ColumnWidth", 28);
-                QAxObject *rows1To5 = worksheetExcel->querySubObject("Range(const QString&)", "1:5");
+                QAxObject *rows1To5 = worksheetExcel->querySubObject("Range(const QString&)", QString("1:%1").arg(lastRow));
                 rows1To5->dynamicCall("RowHeight", 32.5);
                 // 调整列宽以适应内容（可根据需要保留或移除）
                 // QAxObject *usedRange = worksheetExcel->querySubObject("UsedRange");
@@ -443,33 +521,74 @@ void SystemWindow::onExportButtonClicked()
         }
     }
 }
-void SystemWindow::onTotalTimesRuleClicked() {
-    // 总次数规则按钮，选定或取消选定
-    if (manager) {
-        manager->setUseTotalTimesRule(ui->times_rule->isChecked());
+void SystemWindow::onDiffExportButtonClicked()
+{
+    // 导出排班变动按钮点击事件
+    if (!scheduleDiff.isComputed()) {
+        QMessageBox::information(this, "导出排班变动", "至少需要排班两次才能比较变动。");
+        return;
+    }
+    QString filePath = QFileDialog::getSaveFileName(this, "导出排班变动", "排班变动.csv", "CSV 文件 (*.csv)");
+    if (!filePath.isEmpty() && !scheduleDiff.exportCsv(filePath, memberHandles, siteRegistry)) {
+        QMessageBox::critical(this, "导出失败", "无法写入文件：" + filePath);
     }
 }
-
-void SystemWindow::onRadioButtonClicked()
+void SystemWindow::onCalendarExportButtonClicked()
 {
-    // 当单选按钮被点击时，更新交接规则信息
-    if (manager) {
-        if (ui->Monday_handover_rule_radioButton->isChecked()) {
-            manager->setHandoverRule(SchedulingManager::MondayHandoverRule);
-        } else if (ui->All_handover_rule_radioButton->isChecked()) {
-            manager->setHandoverRule(SchedulingManager::AllHandoverRule);
-        } else if (ui->No_handover_rule_radioButton->isChecked()) {
-            manager->setHandoverRule(SchedulingManager::NoRule);
-        }
+    // 导出执勤日历按钮点击事件
+    // 从执勤历史中取最近半年（约一学期）到本次排班那一周的排班，每名队员一个.ics文件，另附一个合并的日历
+    QString directory = QFileDialog::getExistingDirectory(this, "选择执勤日历的保存位置");
+    if (directory.isEmpty()) {
+        return;
+    }
+    QDate to = scheduledWeekMonday().addDays(siteRegistry.dayCount() - 1);
+    QDate from = to.addMonths(-6);
+    DutyCalendarExporter exporter(siteRegistry);
+    exporter.addHistory(history, from, to);
+    if (exporter.memberCount() == 0) {
+        QMessageBox::information(this, "导出执勤日历", "最近一学期没有排班记录。");
+        return;
     }
+    int written = exporter.writePerMember(directory);
+    if (written < 0 || !exporter.writeCombined(QDir(directory).filePath("全部执勤.ics"))) {
+        QMessageBox::critical(this, "导出失败", "无法写入文件夹：" + directory);
+        return;
+    }
+    QMessageBox::information(this, "导出成功", QString("已为 %1 名队员导出执勤日历，合并日历为“全部执勤.ics”。").arg(written));
+}
+void SystemWindow::onSheetExportButtonClicked()
+{
+    // 导出执勤表PDF按钮点击事件
+    // 为本次排班的每名执勤队员和每个组各导出一张PDF执勤表，由线程池并行绘制
+    if (!lastDutyWeek.valid) {
+        QMessageBox::information(this, "导出执勤表", "请先制表。");
+        return;
+    }
+    QString directory = QFileDialog::getExistingDirectory(this, "选择执勤表的保存位置");
+    if (directory.isEmpty()) {
+        return;
+    }
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    DutySheetRenderer renderer(siteRegistry, lastDutyWeek);
+    int written = renderer.render(directory);
+    QApplication::restoreOverrideCursor();
+    if (written < 0) {
+        QMessageBox::critical(this, "导出失败", "无法写入文件夹：" + directory);
+        return;
+    }
+    if (written < renderer.sheetCount()) {
+        QMessageBox::warning(this, "导出执勤表", QString("共 %1 张执勤表，其中 %2 张无法写入。").arg(renderer.sheetCount()).arg(renderer.sheetCount() - written));
+        return;
+    }
+    QMessageBox::information(this, "导出成功", QString("已导出 %1 张执勤表。").arg(written));
 }
-
 
 
 //队员管理界面函数实现
 void SystemWindow::onGroupAddButtonClicked(int groupIndex)
 {
     //添加队员按钮点击事件
+    TraceScope trace("SystemWindow::onGroupAddButtonClicked", "slot");
     bool isChecked = false;
     //判断是哪个组发出的信号，修改新队员的是否值周状态
     switch (groupIndex) {
@@ -478,43 +597,39 @@ void SystemWindow::onGroupAddButtonClicked(int groupIndex)
     case 3: isChecked = ui->group3_iswork_radioButton->isChecked(); break;
     case 4: isChecked = ui->group4_iswork_radioButton->isChecked(); break;
     } 
-    bool time[4][5];
-    //初始化所有执勤时间，默认为全部可以执勤
-    for (int i = 0; i < 4; ++i) {
-        for (int g = 0; g < 5; ++g) {
-            time[i][g] = false;
-        }
-    }
+    //初始化所有执勤时间，默认为全部没空
+    bool time[Person::maxTimeRows][Person::maxDays] = {};
 
     // 生成唯一的默认名字
     std::string defaultNameBase = "未命名队员";
     int counter = 1;
     std::string defaultName = defaultNameBase + std::to_string(counter);
 
-    // 获取所有队员的名字
-    std::vector<std::string> existingNames;
+    // 获取所有队员的名字，放入哈希集合，每次检查只需一次查找
+    std::unordered_set<std::string> existingNames;
     for (int i = 1; i <= 4; ++i) {
         const auto& members = flagGroup.getGroupMembers(i);
         for (const auto& member : members) {
-            existingNames.push_back(member.getName());
+            existingNames.insert(member.getName());
         }
     }
 
     // 检查名字是否重复，若重复则递增计数器
-    while (std::find(existingNames.begin(), existingNames.end(), defaultName) != existingNames.end()) {
+    while (existingNames.count(defaultName)) {
         counter++;
         defaultName = defaultNameBase + std::to_string(counter);
     }
     //初始化新队员的基础信息
     Person person(defaultName, false, groupIndex, "", "", "", "", "", "", "", isChecked, time, 0, 0);
-    //向flagGroup中添加新队员
-    flagGroup.addPersonToGroup(person, groupIndex);
-    //更新对应组的ListView组员标签信息
-    updateListView(groupIndex);
+    //向flagGroup中添加新队员，模型只通知界面新增的这一行
+    undoStack.recordMembers(flagGroup, {});
+    listModels[groupIndex - 1]->addPerson(person);
+    undoStack.recordAdded(flagGroup, groupIndex, 1); // 撤销时删除新队员
 }
 void SystemWindow::onGroupDeleteButtonClicked(int groupIndex)
 {
     //删除队员按钮点击事件
+    TraceScope trace("SystemWindow::onGroupDeleteButtonClicked", "slot");
     QListView* listView = nullptr;
     //判断是哪个组发出的信号，以及信号情况
     switch (groupIndex) {
@@ -536,14 +651,18 @@ void SystemWindow::onGroupDeleteButtonClicked(int groupIndex)
         const auto& members = flagGroup.getGroupMembers(groupIndex);
         if (static_cast<std::vector<Person>::size_type>(row) < members.size()) {
             const Person& personToRemove = members[row];
-            flagGroup.removePersonFromGroup(personToRemove, groupIndex);// 调用 Flag_group 的删除成员方法
-            updateListView(groupIndex);//更新对应组的ListView组员标签信息
+            undoStack.recordMembers(flagGroup, {&personToRemove});
+            if (&personToRemove == currentSelectedPerson) {
+                currentSelectedPerson = nullptr; // 被删除的队员正处于选中状态，清除选中指针，避免悬空
+            }
+            listModels[groupIndex - 1]->removePerson(personToRemove);// 通过模型删除队员，模型只通知界面删除的这一行
         }
     }
 }
 void SystemWindow::onGroupIsWorkRadioButtonClicked(int groupIndex)
 {
     //是否值周确认按钮点击事件
+    TraceScope trace("SystemWindow::onGroupIsWorkRadioButtonClicked", "slot");
     bool isChecked = false;
     //判断是哪个组发出的信号，以及信号情况
     switch (groupIndex) {
@@ -552,17 +671,17 @@ void SystemWindow::onGroupIsWorkRadioButtonClicked(int groupIndex)
     case 3: isChecked = ui->group3_iswork_radioButton->isChecked(); break;
     case 4: isChecked = ui->group4_iswork_radioButton->isChecked(); break;
     }
-    //获取对应组别所有队员
-    const auto& members = flagGroup.getGroupMembers(groupIndex);
     //设置对应组别所有队员isWork属性，选中设为1，取消选中设为0
-    for (auto& member : const_cast<std::vector<Person>&>(members)) {
-        member.setIsWork(isChecked);
-    }
+    //通过模型批量修改，整组只发出一次修改通知
+    undoStack.recordGroup(flagGroup, groupIndex);
+    listModels[groupIndex - 1]->editMembers([isChecked](Person& member) { member.setIsWork(isChecked); },
+                                            {RosterListModel::DutyRole});
 }
 void SystemWindow::onListViewItemClicked(const QModelIndex &index, int groupIndex)
 {
     //队员标签点击事件
     //显示选中队员的信息
+    TraceScope trace("SystemWindow::onListViewItemClicked", "slot");
     Person* person = getSelectedPerson(groupIndex, index);//捕捉被点击的队员是谁
     if (person) {
         currentSelectedPerson = person;
@@ -584,6 +703,7 @@ Person* SystemWindow::getSelectedPerson(int groupIndex, const QModelIndex &index
 void SystemWindow::onInfoLineEditChanged()
 {
     // 信息修改后更新 Flag_group 中队员的信息,不包括点击队员标签时显示队员信息时造成的修改
+    TraceScope trace("SystemWindow::onInfoLineEditChanged", "slot");
     if (currentSelectedPerson && !isShowingInfo) {
         updatePersonInfo(*currentSelectedPerson);
     }
@@ -591,10 +711,12 @@ void SystemWindow::onInfoLineEditChanged()
 void SystemWindow::onGroupComboBoxChanged(int newGroupIndex)
 {
     // 独立的修改组别函数
+    TraceScope trace("SystemWindow::onGroupComboBoxChanged", "slot");
     if (currentSelectedPerson && !isShowingInfo) {
         int oldGroupIndex = currentSelectedPerson->getGroup();//值为1~4
         if((oldGroupIndex - 1) != newGroupIndex)//规避并未修改组别引发多余操作
         {
+            undoStack.recordMembers(flagGroup, {currentSelectedPerson});
             newGroupIndex += 1; // combobox 索引从 0 开始，组索引从 1 开始
             currentSelectedPerson->setGroup(newGroupIndex);// 更新队员的组别信息
             bool isChecked = false;
@@ -605,39 +727,30 @@ void SystemWindow::onGroupComboBoxChanged(int newGroupIndex)
             case 4: isChecked = ui->group4_iswork_radioButton->isChecked(); break;
             }
             currentSelectedPerson->setIsWork(isChecked);
-            flagGroup.addPersonToGroup(*currentSelectedPerson, newGroupIndex);// 将队员添加到新组中
-            updateListView(newGroupIndex);// 更新新组组别信息
-            Person* person = flagGroup.findPersonInGroup(*currentSelectedPerson, newGroupIndex);//创建一个新的队员指针跟踪新创建的队员
-            flagGroup.removePersonFromGroup(*currentSelectedPerson, oldGroupIndex);// 从旧组中删除队员
-            updateListView(oldGroupIndex);// 更新旧组组别信息
+            int newRow = listModels[newGroupIndex - 1]->addPerson(*currentSelectedPerson);// 将队员添加到新组中
+            Person* person = &flagGroup.getGroupMembers(newGroupIndex)[newRow];//创建一个新的队员指针跟踪新创建的队员
+            listModels[oldGroupIndex - 1]->removePerson(*currentSelectedPerson);// 从旧组中删除队员
             currentSelectedPerson = person;// 更新当前选中的队员指针
         }
     }
 }
-void SystemWindow::updateListView(int groupIndex)
+void SystemWindow::setupListViews()
 {
-    // 更新队员标签界面
-    QListView* listView = nullptr;
-    switch (groupIndex) {
-    case 1: listView = ui->group1_info_listView; break;
-    case 2: listView = ui->group2_info_listView; break;
-    case 3: listView = ui->group3_info_listView; break;
-    case 4: listView = ui->group4_info_listView; break;
-    }
-    if (!listView) return;
-    const auto& members = flagGroup.getGroupMembers(groupIndex);
-    QStringList memberNames;
-    for (const auto& member : members) {
-        memberNames << QString::fromStdString(member.getName());
+    // 为四个组的队员标签界面绑定模型
+    // 模型以窗口为父对象，随窗口一同释放；之后的增删改都由模型按行通知界面，不再重建模型
+    QListView* listViews[4] = { ui->group1_info_listView, ui->group2_info_listView,
+                                ui->group3_info_listView, ui->group4_info_listView };
+    for (int groupIndex = 1; groupIndex <= 4; ++groupIndex) {
+        listModels[groupIndex - 1] = new RosterListModel(flagGroup, groupIndex, this);
+        listViews[groupIndex - 1]->setModel(listModels[groupIndex - 1]);
+        // 队员姓名长度相近，统一行高，使列表视图无需逐行测量即可完成布局
+        listViews[groupIndex - 1]->setUniformItemSizes(true);
     }
-    // 使用 QStringListModel 替代 QStandardItemModel
-    QStringListModel *model = new QStringListModel();//创建一个 QStringListModel 对象 model，它是 QAbstractItemModel 的子类，专门用于处理字符串列表数据
-    model->setStringList(memberNames);//调用 model 的 setStringList 方法，将 memberNames 列表中的数据设置到模型中。
-    listView->setModel(model);//调用 listView 的 setModel 方法，将 model 设置为 listView 的数据模型。这样，listView 就会显示 model 中的数据，即指定组别的队员姓名。
 }
 void SystemWindow::showMemberInfo(const Person &person)
 {
     // 根据选中的队员向UI中展示队员基础信息
+    TraceScope trace("SystemWindow::showMemberInfo", "ui");
     ui->name_lineEdit->setText(QString::fromStdString(person.getName()));
     ui->phone_lineEdit->setText(QString::fromStdString(person.getPhone_number()));
     ui->nativePlace_lineEdit->setText(QString::fromStdString(person.getNative_place()));
@@ -648,11 +761,22 @@ void SystemWindow::showMemberInfo(const Person &person)
     ui->birthday_lineEdit->setText(QString::fromStdString(person.getBirthday()));
     ui->gender_combobox->setCurrentText(person.getGender() ? "女" : "男");
     ui->group_combobox->setCurrentIndex(person.getGroup() - 1);//group_combobox默认以0开始，与组名最小为1相违背
+    // 在姓名栏的提示信息中展示执勤历史：最近一次执勤与近30天执勤次数
+    ScheduleHistory::Duty lastDuty;
+    QString historyText = "暂无执勤记录";
+    if (history.lastDuty(person, lastDuty)) {
+        QDate today = QDate::currentDate();
+        int timeRow = siteRegistry.timeRow(lastDuty.slot, lastDuty.location);
+        historyText = "最近一次执勤：" + lastDuty.date.toString("yyyy-MM-dd") + " " + siteRegistry.rowLabel(timeRow)
+                      + "\n近30天执勤次数：" + QString::number(history.dutyCount(person, today.addDays(-30), today));
+    }
+    ui->name_lineEdit->setToolTip(historyText);
 }
 void SystemWindow::updatePersonInfo(const Person &person)
 {
     // 仅更新基础信息部分，执勤安排不调整
     // 从 UI 中获取更新后的信息，修改flag_group中队员信息
+    TraceScope trace("SystemWindow::updatePersonInfo", "ui");
     QString name = ui->name_lineEdit->text();
     QString phone = ui->phone_lineEdit->text();
     QString nativePlace = ui->nativePlace_lineEdit->text();
@@ -663,10 +787,10 @@ void SystemWindow::updatePersonInfo(const Person &person)
     QString birthday = ui->birthday_lineEdit->text();
     bool gender = ui->gender_combobox->currentText() == "女";
     // 创建新的 Person 对象
-    bool time[4][5];
+    bool time[Person::maxTimeRows][Person::maxDays];
     //time 数组保持不变
-    for (int i = 0; i < 4; ++i) {
-        for (int j = 0; j < 5; ++j) {
+    for (int i = 0; i < Person::maxTimeRows; ++i) {
+        for (int j = 0; j < Person::maxDays; ++j) {
             time[i][j] = person.getTime(i + 1, j + 1);
         }
     }
@@ -674,80 +798,109 @@ void SystemWindow::updatePersonInfo(const Person &person)
                      nativePlace.toStdString(), native.toStdString(), dorm.toStdString(),
                      school.toStdString(), classname.toStdString(), birthday.toStdString(), person.getIsWork(),
                      time, person.getTimes(), person.getAll_times());
-    // 更新 flagGroup 中对应队员的信息
-    flagGroup.modifyPersonInGroup(person, newPerson, person.getGroup());
-    // 更新对应组的 ListView 显示
-    updateListView(person.getGroup());
-
+    // 文本框失去焦点也会触发本函数，信息未变化时不做修改，也不产生撤销记录
+    if (newPerson.hasSameInfo(person)) {
+        return;
+    }
+    undoStack.recordMembers(flagGroup, {&person});
+    // 更新 flagGroup 中对应队员的信息，模型只刷新该队员所在的一行
+    int groupIndex = person.getGroup();
+    listModels[groupIndex - 1]->modifyPerson(person, newPerson);
+}
+void SystemWindow::setupAttendanceButtons()
+{
+    // 出勤安排按钮对照表，行列与队员执勤时间表（Person::getTime）一致
+    // 界面文件中为默认登记表画好了按钮：每个（仪式，工作日）一个分组框，框内为“全选”与南鉴湖、东西院两个按钮，
+    // 分组框在按钮栏的网格中第1行起为各仪式，第0列起为各工作日。登记表有更多地点、仪式或工作日时，补建的分组框与按钮放在同样的位置，
+    // 登记表用不到的分组框与按钮隐藏
+    QGroupBox* const designedBoxes[2][5] = {
+        {ui->monday_up_groupBox, ui->tuesday_up_groupBox, ui->wednesday_up_groupBox, ui->thursday_up_groupBox, ui->friday_up_groupBox},
+        {ui->monday_down_groupBox, ui->tuesday_down_groupBox, ui->wednesday_down_groupBox, ui->thursday_down_groupBox, ui->friday_down_groupBox}
+    };
+    QAbstractButton* const designedButtons[2][5][2] = {
+        {{ui->monday_up_NJH_pushButton, ui->monday_up_DXY_pushButton}, {ui->tuesday_up_NJH_pushButton, ui->tuesday_up_DXY_pushButton},
+         {ui->wednesday_up_NJH_pushButton, ui->wednesday_up_DXY_pushButton}, {ui->thursday_up_NJH_pushButton, ui->thursday_up_DXY_pushButton},
+         {ui->friday_up_NJH_pushButton, ui->friday_up_DXY_pushButton}},
+        {{ui->monday_down_NJH_pushButton, ui->monday_down_DXY_pushButton}, {ui->tuesday_down_NJH_pushButton, ui->tuesday_down_DXY_pushButton},
+         {ui->wednesday_down_NJH_pushButton, ui->wednesday_down_DXY_pushButton}, {ui->thursday_down_NJH_pushButton, ui->thursday_down_DXY_pushButton},
+         {ui->friday_down_NJH_pushButton, ui->friday_down_DXY_pushButton}}
+    };
+    for (int halfDay = 0; halfDay < 2; ++halfDay) {
+        for (int day = 0; day < 5; ++day) {
+            designedBoxes[halfDay][day]->setVisible(halfDay < siteRegistry.ceremonyCount() && day < siteRegistry.dayCount());
+            for (int location = 0; location < 2; ++location) {
+                designedButtons[halfDay][day][location]->setVisible(location < siteRegistry.siteCount());
+            }
+        }
+    }
+    for (int halfDay = 0; halfDay < siteRegistry.ceremonyCount(); ++halfDay) {
+        for (int day = 0; day < siteRegistry.dayCount(); ++day) {
+            QGroupBox* box = halfDay < 2 && day < 5 ? designedBoxes[halfDay][day] : nullptr;
+            if (!box) {
+                box = new QGroupBox(ui->availableTime_groupBox);
+                QVBoxLayout* layout = new QVBoxLayout(box);
+                QPushButton* allButton = new QPushButton("全选", box);
+                allButton->setObjectName(QString("extra_%1_%2_all_pushButton").arg(halfDay).arg(day));
+                layout->addWidget(allButton);
+                connect(allButton, &QAbstractButton::clicked, this, &SystemWindow::onAllSelectButtonClicked);
+                ui->gridLayout_5->addWidget(box, halfDay + 1, day);
+            }
+            box->setTitle(siteRegistry.dayName(day) + siteRegistry.ceremony(halfDay).name);
+            int slot = day * siteRegistry.ceremonyCount() + halfDay;
+            for (int location = 0; location < siteRegistry.siteCount(); ++location) {
+                QAbstractButton* button = halfDay < 2 && day < 5 && location < 2 ? designedButtons[halfDay][day][location] : nullptr;
+                if (!button) {
+                    button = new QPushButton(box);
+                    button->setCheckable(true);
+                    box->layout()->addWidget(button);
+                }
+                button->setText(siteRegistry.site(location).name);
+                timeButtons[siteRegistry.timeRow(slot, location) - 1][day] = button;
+                connect(button, &QAbstractButton::clicked, [this, button](bool) {onAttendanceButtonClicked(button);});
+            }
+        }
+    }
 }
 void SystemWindow::updateAttendanceButtons(const Person &person)
 {
     // 根据队员的time数组调整按钮显示的状态
-    // 周一升旗
-    ui->monday_up_NJH_pushButton->setChecked(person.getTime(1, 1));
-    ui->monday_up_DXY_pushButton->setChecked(person.getTime(2, 1));
-    // 周二升旗
-    ui->tuesday_up_NJH_pushButton->setChecked(person.getTime(1, 2));
-    ui->tuesday_up_DXY_pushButton->setChecked(person.getTime(2, 2));
-    // 周三升旗
-    ui->wednesday_up_NJH_pushButton->setChecked(person.getTime(1, 3));
-    ui->wednesday_up_DXY_pushButton->setChecked(person.getTime(2, 3));
-    // 周四升旗
-    ui->thursday_up_NJH_pushButton->setChecked(person.getTime(1, 4));
-    ui->thursday_up_DXY_pushButton->setChecked(person.getTime(2, 4));
-    // 周五升旗
-    ui->friday_up_NJH_pushButton->setChecked(person.getTime(1, 5));
-    ui->friday_up_DXY_pushButton->setChecked(person.getTime(2, 5));
-    // 周一降旗
-    ui->monday_down_NJH_pushButton->setChecked(person.getTime(3, 1));
-    ui->monday_down_DXY_pushButton->setChecked(person.getTime(4, 1));
-    // 周二降旗
-    ui->tuesday_down_NJH_pushButton->setChecked(person.getTime(3, 2));
-    ui->tuesday_down_DXY_pushButton->setChecked(person.getTime(4, 2));
-    // 周三降旗
-    ui->wednesday_down_NJH_pushButton->setChecked(person.getTime(3, 3));
-    ui->wednesday_down_DXY_pushButton->setChecked(person.getTime(4, 3));
-    // 周四降旗
-    ui->thursday_down_NJH_pushButton->setChecked(person.getTime(3, 4));
-    ui->thursday_down_DXY_pushButton->setChecked(person.getTime(4, 4));
-    // 周五降旗
-    ui->friday_down_NJH_pushButton->setChecked(person.getTime(3, 5));
-    ui->friday_down_DXY_pushButton->setChecked(person.getTime(4, 5));
+    // 全部按钮一起更新：屏蔽按钮信号，并暂停按钮栏的重绘，全部设置完成后只重绘一次
+    TraceScope trace("SystemWindow::updateAttendanceButtons", "ui");
+    ui->availableTime_groupBox->setUpdatesEnabled(false);
+    for (int row = 0; row < siteRegistry.timeRowCount(); ++row) {
+        for (int day = 0; day < siteRegistry.dayCount(); ++day) {
+            QSignalBlocker blocker(timeButtons[row][day]);
+            timeButtons[row][day]->setChecked(person.getTime(row + 1, day + 1));
+        }
+    }
+    ui->availableTime_groupBox->setUpdatesEnabled(true);
+}
+bool SystemWindow::findTimeButton(QAbstractButton *button, int &row, int &column) const
+{
+    // 在出勤安排按钮对照表中查找按钮，row、column为对应的time数组行列（最小值为1），不是出勤安排按钮时返回false
+    for (int r = 0; r < siteRegistry.timeRowCount(); ++r) {
+        for (int c = 0; c < siteRegistry.dayCount(); ++c) {
+            if (timeButtons[r][c] == button) {
+                row = r + 1;
+                column = c + 1;
+                return true;
+            }
+        }
+    }
+    return false;
 }
 void SystemWindow::onAttendanceButtonClicked(QAbstractButton *button)
 {
     // 执勤按钮点击事件
     // 根据按钮修改time数组信息
+    TraceScope trace("SystemWindow::onAttendanceButtonClicked", "slot");
     Person* currentPerson = currentSelectedPerson;
     if (currentPerson) {
-        // 定义按钮到 (row, column) 的映射,使用映射表来存储按钮和对应的 setTime 方法所需的行、列参数，这样可以避免大量重复的条件判断。
-        static QMap<QAbstractButton*, std::pair<int, int>> buttonToTimeMap = {
-            {ui->monday_up_NJH_pushButton, {1, 1}},
-            {ui->monday_up_DXY_pushButton, {2, 1}},
-            {ui->tuesday_up_NJH_pushButton, {1, 2}},
-            {ui->tuesday_up_DXY_pushButton, {2, 2}},
-            {ui->wednesday_up_NJH_pushButton, {1, 3}},
-            {ui->wednesday_up_DXY_pushButton, {2, 3}},
-            {ui->thursday_up_NJH_pushButton, {1, 4}},
-            {ui->thursday_up_DXY_pushButton, {2, 4}},
-            {ui->friday_up_NJH_pushButton, {1, 5}},
-            {ui->friday_up_DXY_pushButton, {2, 5}},
-            {ui->monday_down_NJH_pushButton, {3, 1}},
-            {ui->monday_down_DXY_pushButton, {4, 1}},
-            {ui->tuesday_down_NJH_pushButton, {3, 2}},
-            {ui->tuesday_down_DXY_pushButton, {4, 2}},
-            {ui->wednesday_down_NJH_pushButton, {3, 3}},
-            {ui->wednesday_down_DXY_pushButton, {4, 3}},
-            {ui->thursday_down_NJH_pushButton, {3, 4}},
-            {ui->thursday_down_DXY_pushButton, {4, 4}},
-            {ui->friday_down_NJH_pushButton, {3, 5}},
-            {ui->friday_down_DXY_pushButton, {4, 5}}
-        };
-        // 查找按钮对应的 (row, column)
-        auto it = buttonToTimeMap.find(button);
-        if (it != buttonToTimeMap.end()) {
-            int row = it.value().first;
-            int column = it.value().second;
+        // 在出勤安排按钮对照表中查找按钮对应的 (row, column)
+        int row = 0;
+        int column = 0;
+        if (findTimeButton(button, row, column)) {
+            undoStack.recordMembers(flagGroup, {currentPerson});
             currentPerson->setTime(row, column, button->isChecked());
         }
     }
@@ -755,77 +908,236 @@ void SystemWindow::onAttendanceButtonClicked(QAbstractButton *button)
 void SystemWindow::onAllSelectButtonClicked()
 {
     //全选按钮点击事件
+    TraceScope trace("SystemWindow::onAllSelectButtonClicked", "slot");
     QAbstractButton* senderButton = qobject_cast<QAbstractButton*>(sender());
     if (!senderButton || !currentSelectedPerson) return;
     // 获取当前点击的“全选”按钮所在的 groupBox
     QGroupBox* parentGroupBox = qobject_cast<QGroupBox*>(senderButton->parent());
     if (!parentGroupBox) return;
-    // 获取 groupBox 中的其他两个按钮
-    QList<QAbstractButton*> childButtons = parentGroupBox->findChildren<QAbstractButton*>();
-    for (QAbstractButton* button : childButtons) {
-        if (button != senderButton) {
-            button->setChecked(true);
+    // 获取 groupBox 中的其他按钮（每个地点一个）
+    // 先算出新的 time 数组，一次写入队员，只产生一条撤销记录
+    bool newTime[Person::maxTimeRows][Person::maxDays];
+    for (int i = 0; i < Person::maxTimeRows; ++i) {
+        for (int j = 0; j < Person::maxDays; ++j) {
+            newTime[i][j] = currentSelectedPerson->getTime(i + 1, j + 1);
         }
     }
-    // 更新对应 time 数组
-    static QMap<QAbstractButton*, std::pair<int, int>> buttonToTimeMap = {
-        {ui->monday_up_NJH_pushButton, {1, 1}},
-        {ui->monday_up_DXY_pushButton, {2, 1}},
-        {ui->tuesday_up_NJH_pushButton, {1, 2}},
-        {ui->tuesday_up_DXY_pushButton, {2, 2}},
-        {ui->wednesday_up_NJH_pushButton, {1, 3}},
-        {ui->wednesday_up_DXY_pushButton, {2, 3}},
-        {ui->thursday_up_NJH_pushButton, {1, 4}},
-        {ui->thursday_up_DXY_pushButton, {2, 4}},
-        {ui->friday_up_NJH_pushButton, {1, 5}},
-        {ui->friday_up_DXY_pushButton, {2, 5}},
-        {ui->monday_down_NJH_pushButton, {3, 1}},
-        {ui->monday_down_DXY_pushButton, {4, 1}},
-        {ui->tuesday_down_NJH_pushButton, {3, 2}},
-        {ui->tuesday_down_DXY_pushButton, {4, 2}},
-        {ui->wednesday_down_NJH_pushButton, {3, 3}},
-        {ui->wednesday_down_DXY_pushButton, {4, 3}},
-        {ui->thursday_down_NJH_pushButton, {3, 4}},
-        {ui->thursday_down_DXY_pushButton, {4, 4}},
-        {ui->friday_down_NJH_pushButton, {3, 5}},
-        {ui->friday_down_DXY_pushButton, {4, 5}}
-    };
+    QList<QAbstractButton*> childButtons = parentGroupBox->findChildren<QAbstractButton*>();
     for (QAbstractButton* button : childButtons) {
-        if (button != senderButton) {
-            auto it = buttonToTimeMap.find(button);
-            if (it != buttonToTimeMap.end()) {
-                int row = it.value().first;
-                int column = it.value().second;
-                currentSelectedPerson->setTime(row, column, true);
-            }
+        int row = 0;
+        int column = 0;
+        if (button != senderButton && findTimeButton(button, row, column)) {
+            QSignalBlocker blocker(button);
+            button->setChecked(true);
+            newTime[row - 1][column - 1] = true;
         }
     }
+    undoStack.recordMembers(flagGroup, {currentSelectedPerson});
+    currentSelectedPerson->setTime(newTime);
 }
 void SystemWindow::onIsWorkPushButtonClicked()
 {
     // 全选/清空按钮点击事件
     // 切换所有出勤按钮的选中状态，并更新 Person 的 time 数组。
+    TraceScope trace("SystemWindow::onIsWorkPushButtonClicked", "slot");
     static bool isAllChecked = false;// 一次创建，全局生命周期，第一次点击实现全选功能
     isAllChecked = !isAllChecked;
     // 获取 availableTime_groupBox 中的所有按钮
     QList<QAbstractButton*> attendanceButtons = ui->availableTime_groupBox->findChildren<QAbstractButton*>();
-    // 遍历所有按钮，设置选中状态
+    // 遍历所有按钮，设置选中状态。屏蔽按钮信号，暂停重绘，全部设置完成后只重绘一次
+    ui->availableTime_groupBox->setUpdatesEnabled(false);
     for (QAbstractButton* button : attendanceButtons) {
         // 排除以 all_pushButton 结尾的全选按钮
         if (!button->objectName().endsWith("all_pushButton")) {
+            QSignalBlocker blocker(button);
             button->setChecked(isAllChecked);
         }
     }
+    ui->availableTime_groupBox->setUpdatesEnabled(true);
     // 调用当前选中的队员信息
     Person* person = currentSelectedPerson;
     if (person) {
-        // 根据 isAllChecked 更新 time 数组
-        bool newTime[4][5];
-        for (int i = 0; i < 4; ++i) {
-            for (int j = 0; j < 5; ++j) {
-                newTime[i][j] = isAllChecked;
+        undoStack.recordMembers(flagGroup, {person});
+        // 根据 isAllChecked 更新 time 数组中登记表用到的行列
+        bool newTime[Person::maxTimeRows][Person::maxDays];
+        for (int i = 0; i < Person::maxTimeRows; ++i) {
+            for (int j = 0; j < Person::maxDays; ++j) {
+                newTime[i][j] = i < siteRegistry.timeRowCount() && j < siteRegistry.dayCount() ? isAllChecked : person->getTime(i + 1, j + 1);
             }
         }
         person->setTime(newTime);
     }
 }
+void SystemWindow::onSearchTextChanged(const QString &text)
+{
+    // 搜索框内容修改事件，边输入边搜索
+    TraceScope trace("SystemWindow::onSearchTextChanged", "slot");
+    static const QString groupNames[] = { "一组", "二组", "三组", "四组" };
+    ui->search_listWidget->clear();
+    const auto results = searchIndex->search(text);
+    for (const auto& result : results) {
+        QListWidgetItem* item = new QListWidgetItem(result.name + "（" + groupNames[result.groupNumber - 1] + "）");
+        item->setData(Qt::UserRole, result.groupNumber); // 保存组别
+        item->setData(Qt::UserRole + 1, result.docId); // 保存索引编号，点击时换算为组内行号
+        item->setData(Qt::UserRole + 2, result.generation); // 保存索引整理次数，索引整理后结果过期
+        ui->search_listWidget->addItem(item);
+    }
+}
+void SystemWindow::onSearchResultClicked(QListWidgetItem *item)
+{
+    // 搜索结果点击事件
+    // 在对应组的队员标签中选中该队员，并展示其信息
+    TraceScope trace("SystemWindow::onSearchResultClicked", "slot");
+    MemberSearchIndex::Result result{ item->data(Qt::UserRole).toInt(), item->data(Qt::UserRole + 1).toInt(), item->text(),
+                                      item->data(Qt::UserRole + 2).toInt() };
+    int row = searchIndex->rowOf(result);
+    if (row < 0) {
+        // 队员已被删除或修改，或索引已整理，结果过期，重新搜索一次
+        // 当前仍处于该结果项的点击信号中，延后刷新，避免结果项在使用中被删除
+        QMetaObject::invokeMethod(this, [this]() { onSearchTextChanged(ui->search_lineEdit->text()); }, Qt::QueuedConnection);
+        return;
+    }
+    QListView* listViews[4] = { ui->group1_info_listView, ui->group2_info_listView,
+                                ui->group3_info_listView, ui->group4_info_listView };
+    QModelIndex index = listModels[result.groupNumber - 1]->index(row);
+    listViews[result.groupNumber - 1]->setCurrentIndex(index);
+    onListViewItemClicked(index, result.groupNumber);
+}
+void SystemWindow::onImportButtonClicked()
+{
+    // 导入报名表按钮点击事件
+    QString filePath = QFileDialog::getOpenFileName(this, "导入报名表", "", "报名表 (*.csv *.xlsx)");
+    if (filePath.isEmpty()) {
+        return;
+    }
+    int defaultGroup = ui->import_group_comboBox->currentIndex() + 1;
+    QApplication::setOverrideCursor(Qt::WaitCursor);
+    RosterImporter::Result result = RosterImporter::importFile(filePath, flagGroup, defaultGroup, siteRegistry);
+    QApplication::restoreOverrideCursor();
+    if (!result.error.isEmpty()) {
+        QMessageBox::warning(this, "导入失败", result.error);
+        return;
+    }
+    if (result.imported > 0) {
+        // 新队员是否值周与所在组的“是否值周”状态一致，与“添加组员”相同
+        QRadioButton* isWorkButtons[4] = { ui->group1_iswork_radioButton, ui->group2_iswork_radioButton,
+                                           ui->group3_iswork_radioButton, ui->group4_iswork_radioButton };
+        undoStack.recordMembers(flagGroup, {});
+        for (int i = 0; i < 4; ++i) {
+            for (auto& person : result.persons[i]) {
+                person.setIsWork(isWorkButtons[i]->isChecked());
+            }
+            size_t count = result.persons[i].size();
+            listModels[i]->addPersons(std::move(result.persons[i])); // 每组只通知界面一次
+            undoStack.recordAdded(flagGroup, i + 1, count);
+        }
+    }
+    QMessageBox::information(this, "导入完成", QString("成功导入 %1 名队员\n跳过重复队员 %2 行\n跳过缺少姓名的 %3 行")
+                                               .arg(result.imported).arg(result.duplicates).arg(result.invalid));
+}
+void SystemWindow::onUndoTriggered()
+{
+    // 撤销快捷键事件，恢复上一次修改前的花名册
+    TraceScope trace("SystemWindow::onUndoTriggered", "slot");
+    if (rosterLoader) {
+        return; // 读取期间的撤销记录以尚未读完的花名册为准
+    }
+    if (undoStack.undo(flagGroup)) {
+        reloadRoster();
+    }
+}
+void SystemWindow::onRedoTriggered()
+{
+    // 重做快捷键事件，恢复最近一次被撤销的修改
+    TraceScope trace("SystemWindow::onRedoTriggered", "slot");
+    if (rosterLoader) {
+        return;
+    }
+    if (undoStack.redo(flagGroup)) {
+        reloadRoster();
+    }
+}
+void SystemWindow::startRosterLoading()
+{
+    // 读取完成前花名册不完整，不能制表，也不能导入（无法判断是否与未读出的队员重复）
+    // 也不能新建队员：尚未读出的队员编号未知，新队员分配的编号可能与之重复
+    ui->tabulateButton->setEnabled(false);
+    ui->import_pushButton->setEnabled(false);
+    setAddButtonsEnabled(false);
+    loadedLayoutRevision = flagGroup.getLayoutRevision();
+    rosterLoader = new QFutureWatcher<RosterBatch>(this);
+    // 每读出一批队员，回到界面线程加入对应组，该组的队员标签随之出现
+    connect(rosterLoader, &QFutureWatcher<RosterBatch>::resultsReadyAt, this, [this](int, int end) { applyRosterBatches(end); });
+    connect(rosterLoader, &QFutureWatcher<RosterBatch>::finished, this, &SystemWindow::finishRosterLoading);
+    rosterLoader->setFuture(QtConcurrent::run([file = filename](QPromise<RosterBatch>& promise) {
+        qint64 fileSize = FlagGroupFileManager::loadInBatches(file, [&promise](int groupNumber, std::vector<Person>& persons) {
+            for (auto& person : persons) {
+                person.setIsWork(false); // 对应全组执勤按钮的未选定状态
+            }
+            promise.addResult(RosterBatch{groupNumber, std::move(persons), -1});
+        });
+        promise.addResult(RosterBatch{0, {}, fileSize});
+    }));
+}
+void SystemWindow::applyRosterBatches(int end)
+{
+    TraceScope trace("SystemWindow::applyRosterBatches", "ui");
+    for (; appliedBatches < end; ++appliedBatches) {
+        RosterBatch batch = rosterLoader->resultAt(appliedBatches);
+        if (batch.groupNumber == 0) {
+            loadedFileSize = batch.fileSize;
+            continue;
+        }
+        if (flagGroup.getLayoutRevision() != loadedLayoutRevision) {
+            layoutTouchedDuringLoad = true;
+        }
+        // 加入队员可能使该组的队员指针失效，选中的队员在该组时先记下，加入后重新查找
+        Person selected;
+        bool reselect = currentSelectedPerson && currentSelectedPerson->getGroup() == batch.groupNumber;
+        if (reselect) {
+            selected = *currentSelectedPerson;
+        }
+        listModels[batch.groupNumber - 1]->addPersons(std::move(batch.persons));
+        if (reselect) {
+            currentSelectedPerson = flagGroup.findPersonInGroup(selected, batch.groupNumber);
+        }
+        loadedLayoutRevision = flagGroup.getLayoutRevision();
+    }
+}
+void SystemWindow::finishRosterLoading()
+{
+    if (!rosterLoader) {
+        return; // 关闭窗口时已直接完成
+    }
+    applyRosterBatches(rosterLoader->future().resultCount());
+    rosterLoader->deleteLater();
+    rosterLoader = nullptr;
+    // 读取期间用户没有增删队员时，花名册与文件中的记录一一对应，之后可以只覆盖修改过的记录
+    if (!layoutTouchedDuringLoad && loadedFileSize >= 0 && flagGroup.getLayoutRevision() == loadedLayoutRevision) {
+        flagGroup.markSaved(loadedFileSize);
+    }
+    undoStack.clear(); // 读取期间记下的行号以尚未读完的花名册为准，不能用于撤销
+    ui->tabulateButton->setEnabled(true);
+    ui->import_pushButton->setEnabled(true);
+    setAddButtonsEnabled(true);
+    // 每分钟在后台保存一次修改，程序异常退出时最多丢失一分钟的修改
+    QTimer* autosaveTimer = new QTimer(this);
+    connect(autosaveTimer, &QTimer::timeout, rosterSaver, &RosterSaver::save);
+    autosaveTimer->start(60 * 1000);
+}
+void SystemWindow::setAddButtonsEnabled(bool enabled)
+{
+    ui->group1_add_pushButton->setEnabled(enabled);
+    ui->group2_add_pushButton->setEnabled(enabled);
+    ui->group3_add_pushButton->setEnabled(enabled);
+    ui->group4_add_pushButton->setEnabled(enabled);
+}
+void SystemWindow::reloadRoster()
+{
+    // flagGroup被整体替换后，原先指向队员的指针全部失效，清除选中状态并刷新四个组的队员标签
+    TraceScope trace("SystemWindow::reloadRoster", "ui");
+    currentSelectedPerson = nullptr;
+    for (RosterListModel* model : listModels) {
+        model->reload();
+    }
+}
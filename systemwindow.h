@@ -6,7 +6,18 @@
 
 #include <QMainWindow>
 #include "dataFunction.h"
+#include "modelFunction.h"
+#include "searchFunction.h"
+#include "undoFunction.h"
+#include "historyFunction.h"
+#include "siteFunction.h"
+#include "diffFunction.h"
+#include "saveFunction.h"
+#include "sheetFunction.h"
 #include "qabstractbutton.h"
+#include <QListWidgetItem>
+#include <QFutureWatcher>
+#include <vector>
 QT_BEGIN_NAMESPACE
 namespace Ui {
 class SystemWindow;
@@ -27,9 +38,9 @@ private slots:
     void onClearButtonClicked(); // 清空表格按钮点击事件
     void onResetButtonClicked(); // 重置队员执勤总次数按钮点击事件
     void onExportButtonClicked(); // 导出表格按钮点击事件
-    // 规则管理
-    void onTotalTimesRuleClicked(); // 总次数规则按钮点击事件
-    void onRadioButtonClicked(); // 交接工作单选按钮点击事件
+    void onDiffExportButtonClicked(); // 导出排班变动按钮点击事件
+    void onCalendarExportButtonClicked(); // 导出执勤日历按钮点击事件
+    void onSheetExportButtonClicked(); // 导出执勤表PDF按钮点击事件
     // 制表警告
     void handleSchedulingWarning(const QString& warningMessage); // 排表过程中发送警告信息的对应处理函数
 
@@ -46,10 +57,43 @@ private slots:
     void onAttendanceButtonClicked(QAbstractButton *button); // 事件安排表中执勤按钮点击事件
     void onIsWorkPushButtonClicked(); // 总全选/清空按钮点击事件
     void onAllSelectButtonClicked(); // 全选按钮点击事件
+    // 搜索队员栏
+    void onSearchTextChanged(const QString &text); // 搜索框内容修改事件，边输入边搜索
+    void onSearchResultClicked(QListWidgetItem *item); // 搜索结果点击事件
+    // 批量导入栏
+    void onImportButtonClicked(); // 导入报名表按钮点击事件
+    // 撤销/重做
+    void onUndoTriggered(); // 撤销快捷键（Ctrl+Z）事件
+    void onRedoTriggered(); // 重做快捷键（Ctrl+Y / Ctrl+Shift+Z）事件
 private:
+    // 后台读取数据文件得到的一批队员；groupNumber为0表示读取结束，此时fileSize为文件大小（无法打开文件时为-1）
+    struct RosterBatch {
+        int groupNumber = 0;
+        std::vector<Person> persons;
+        qint64 fileSize = -1;
+    };
+
     Ui::SystemWindow *ui; // ui界面指针
-    SchedulingManager *manager; // 国旗班制表管理器指针
+    SchedulingManager *manager; // 国旗班制表管理器指针，只在排班期间存在
+    QFuture<void> schedulingTask; // 后台排班任务
+    QFutureWatcher<void>* schedulingWatcher = nullptr; // 监视后台排班任务，任务结束后完成收尾，排班期间存在
     Flag_group flagGroup; // 国旗班成员容器变量
+    RosterListModel* listModels[4] = {}; // 四个组的队员标签模型，窗口创建时建立，直接读取flagGroup
+    MemberSearchIndex* searchIndex = nullptr; // 队员搜索索引，随队员标签模型增量更新
+    RosterUndoStack undoStack; // 撤销/重做栈，记下每次修改涉及的队员修改前的信息
+    RosterSaver* rosterSaver = nullptr; // 后台保存花名册，窗口运行期间定时保存
+    QFutureWatcher<RosterBatch>* rosterLoader = nullptr; // 窗口启动时在后台读取数据文件，读取完成后为空
+    int appliedBatches = 0; // 已加入花名册的批数
+    long long loadedLayoutRevision = 0; // 加入最近一批后花名册的增删次数，用于发现读取期间用户增删了队员
+    bool layoutTouchedDuringLoad = false; // 读取期间用户是否增删过队员
+    qint64 loadedFileSize = -1; // 读取的数据文件大小
+    SiteRegistry siteRegistry; // 执勤地点与仪式登记表，启动时从配置文件读取，排班与界面共用
+    ScheduleHistory history{"./data/history.txt", siteRegistry}; // 执勤历史，保存每次排班的结果，岗位布局随登记表
+    MemberHandles memberHandles; // 队员编号表，排班快照以编号保存队员
+    ScheduleSnapshot lastSchedule; // 上一次排班结果的快照
+    ScheduleDiff scheduleDiff; // 本次排班与上一次排班的差异
+    DutyWeek lastDutyWeek; // 上一次排班结果，导出执勤表时使用
+    QAbstractButton* timeButtons[Person::maxTimeRows][Person::maxDays] = {}; // 出勤安排按钮对照表，与队员time数组的行列一致，只用到登记表的行列数
     Person* currentSelectedPerson = nullptr; // 保存当前用户选中的队员标签指针
     bool isShowingInfo = false; // 新增标志位，用于区分展示信息造成的文本框信息修改和用户主动填写造成的信息修改
     QString warningMessages; // 新增成员变量，用于保存警告信息
@@ -58,11 +102,20 @@ private:
     // 值周管理操作函数
     void updateTableWidget(const SchedulingManager& manager); // 制表操作，点击制表按钮后的辅助函数
     void updateTextEdit(const SchedulingManager& manager); // 制表结果在文本域中更新，点击制表按钮后的辅助函数
+    void finishScheduling(); // 后台排班任务结束后写回执勤次数、更新表格并删除排班管理器
+    static QDate scheduledWeekMonday(); // 本次排班对应那一周的周一：周一至周五排本周，周末排下一周
     // 队员管理操作函数
-    void updateListView(int groupIndex); // 更新队员标签界面
+    void setupListViews(); // 为四个组的队员标签界面绑定模型，仅在窗口创建时调用一次
+    void reloadRoster(); // flagGroup被整体替换（撤销/重做）后，刷新队员标签界面
+    void startRosterLoading(); // 在后台读取数据文件，窗口先显示，各组队员边读取边加入
+    void applyRosterBatches(int end); // 把已读出、尚未加入的各批队员加入花名册，直到第end批
+    void finishRosterLoading(); // 读取完成，启用制表、导入与新建队员，开始定时保存
+    void setAddButtonsEnabled(bool enabled); // 启用或禁用四个组的添加队员按钮
     Person* getSelectedPerson(int groupIndex, const QModelIndex &index); // 捕捉被选中的标签是哪个队员，队员标签点击后的辅助函数
     void showMemberInfo(const Person &person); // 根据选中的队员向UI中展示队员基础信息
     void updatePersonInfo(const Person &person); // 从UI中获取更新后的信息，修改flag_group中队员信息，仅更新基础信息部分，执勤安排不调整（根据程序实际设计，队员组别信息修改不在该函数进行）。
+    void setupAttendanceButtons(); // 按登记表建立出勤安排按钮对照表，界面文件之外的行列补建按钮
     void updateAttendanceButtons(const Person &person); // 根据队员的time数组调整按钮显示的状态
+    bool findTimeButton(QAbstractButton *button, int &row, int &column) const; // 查找出勤安排按钮对应的time数组行列
 };
 #endif // SYSTEMWINDOW_H
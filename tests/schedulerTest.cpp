@@ -0,0 +1,319 @@
+// schedulerTest.cpp
+// 功能说明：排班规则与数据文件读取的独立测试程序，不依赖界面
+// 1. 随机生成花名册（人数、有空比例、参加排班比例、总执勤次数都随机），在全部规则组合（总次数规则 × 三种交接规则）
+//    与不同随机数种子下排班，逐次用SchedulingManager::checkInvariants检查排班结果；同一种子再排一次，结果必须相同。
+//    默认登记表与一份三个地点、每天一个仪式、六个工作日的登记表交替使用；
+//    执勤时间与总执勤次数拼接后相同的两份花名册不能共用排班结果缓存
+// 2. 错误数据行集合：每一行都必须被parseLine拒绝；与正常数据行交错写入文件后，loadFromFile只读出正常的队员，编号互不重复；
+//    默认4行 × 5列以外的执勤时间写出后能原样读回
+// 全部通过时返回0，否则输出失败的情况并返回1
+//
+// 编译：tests目录下的tests.pro（qmake && make），源文件为本文件与Person.cpp、Flag_group.cpp，dataFunction.h经过moc处理；
+//       make check以默认参数运行
+// 运行：schedulerTest [排班次数，默认3000] [起始种子，默认1]
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QDir>
+#include <QFile>
+#include <QTemporaryDir>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+#include "../Person.h"
+#include "../Flag_group.h"
+#include "../dataFunction.h"
+#include "../fileFunction.h"
+#include "../siteFunction.h"
+
+namespace {
+
+int failures = 0; // 失败的检查数
+
+void fail(const QString& message) {
+    ++failures;
+    if (failures <= 50) {
+        qCritical().noquote() << message; // 只输出前50条，避免同一个问题刷屏
+    }
+}
+
+// 随机生成一份花名册，seed相同时生成的花名册相同；执勤时间表的全部容量都随机填写，适用于任何登记表
+Flag_group randomRoster(std::mt19937_64& random) {
+    auto between = [&random](int low, int high) { return std::uniform_int_distribution<int>(low, high)(random); };
+    auto chance = [&random](double probability) { return std::uniform_real_distribution<double>(0.0, 1.0)(random) < probability; };
+    Flag_group flagGroup;
+    int members = between(0, 80); // 包括人数不足以排满的花名册
+    double density = between(0, 10) / 10.0; // 有空比例，包括全都没空与全都有空
+    double workRatio = between(0, 10) / 10.0; // 参加排班的比例
+    for (int i = 0; i < members; ++i) {
+        bool time[Person::maxTimeRows][Person::maxDays];
+        for (int row = 0; row < Person::maxTimeRows; ++row) {
+            for (int day = 0; day < Person::maxDays; ++day) {
+                time[row][day] = chance(density);
+            }
+        }
+        int group = between(1, 4);
+        Person person("队员" + std::to_string(i), chance(0.5), group, "", "", "", "", "", "班级" + std::to_string(between(1, 5)), "",
+                      chance(workRatio), time, 0, between(0, 30));
+        flagGroup.addPersonToGroup(std::move(person), group);
+    }
+    return flagGroup;
+}
+
+// 排班结果中每个座位上的队员编号，空岗为0
+std::vector<int> seatIds(const ScheduleTable& table) {
+    std::vector<int> ids;
+    for (const Person* person : table.allSeats()) {
+        ids.push_back(person ? person->getId() : 0);
+    }
+    return ids;
+}
+
+// 三个地点、每天一个仪式、六个工作日的登记表，从临时目录中的配置文件读取
+bool loadWideRegistry(SiteRegistry& registry) {
+    QTemporaryDir directory;
+    QFile file(directory.filePath("sites.txt"));
+    if (!directory.isValid() || !file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write("S|NJH|南鉴湖\nS|DXY|东西院\nS|GYM|体育馆\nC|升旗|上午|07:00|30\n"
+               "D|周一\nD|周二\nD|周三\nD|周四\nD|周五\nD|周六\n");
+    file.close();
+    return registry.load(file.fileName()) && registry.siteCount() == 3 && registry.ceremonyCount() == 1 && registry.dayCount() == 6;
+}
+
+// 随机花名册、规则组合、登记表与种子下反复排班，检查排班规则
+void testSchedulingInvariants(int runs, quint64 firstSeed) {
+    const SchedulingManager::HandoverRule rules[] = { SchedulingManager::NoRule, SchedulingManager::MondayHandoverRule,
+                                                      SchedulingManager::AllHandoverRule };
+    SiteRegistry wideRegistry;
+    if (!loadWideRegistry(wideRegistry)) {
+        fail("无法读取测试用的执勤地点与仪式配置");
+        return;
+    }
+    std::mt19937_64 random(firstSeed);
+    for (int run = 0; run < runs; ++run) {
+        Flag_group flagGroup = randomRoster(random);
+        bool useTotalTimesRule = run % 2 == 1;
+        SchedulingManager::HandoverRule handoverRule = rules[run / 2 % 3];
+        const SiteRegistry& registry = run / 6 % 2 == 0 ? SiteRegistry::defaults() : wideRegistry;
+        quint64 seed = firstSeed + static_cast<quint64>(run);
+        QString context = QString("第%1次排班（种子%2，总次数规则%3，交接规则%4，%5个地点）：")
+                              .arg(run).arg(seed).arg(useTotalTimesRule).arg(handoverRule).arg(registry.siteCount());
+
+        SchedulingManager manager(flagGroup, useTotalTimesRule, handoverRule, registry);
+        manager.setSeed(seed);
+        manager.setCacheEnabled(false); // 每次都真正排一次班
+        manager.schedule();
+        const QStringList violations = manager.checkInvariants();
+        for (const QString& violation : violations) {
+            fail(context + violation);
+        }
+        // 相同的花名册、规则与种子必然得到相同的结果
+        SchedulingManager again(flagGroup, useTotalTimesRule, handoverRule, registry);
+        again.setSeed(seed);
+        again.setCacheEnabled(false);
+        again.schedule();
+        if (seatIds(again.getScheduleTable()) != seatIds(manager.getScheduleTable())) {
+            fail(context + "相同种子两次排班的结果不同");
+        }
+    }
+    qInfo().noquote() << QString("排班规则检查：%1次排班").arg(runs);
+}
+
+// 两份花名册各只有一名编号相同的队员：执勤时间位12（周三、周四南鉴湖升旗）、总执勤次数3，
+// 与执勤时间位1（周一南鉴湖升旗）、总次数23。采用总次数规则先后排班，后一次不能复用前一次的缓存结果
+void testCacheKeyCollision(quint64 seed) {
+    auto roster = [](quint64 timeBits, int allTimes) {
+        Flag_group flagGroup;
+        bool time[Person::maxTimeRows][Person::maxDays] = {};
+        Person person("队员", false, 1, "", "", "", "", "", "班级", "", true, time, 0, allTimes);
+        person.setTimeBits(timeBits);
+        flagGroup.addPersonToGroup(std::move(person), 1);
+        return flagGroup;
+    };
+    Flag_group first = roster(12, 3);
+    Flag_group second = roster(1, 23);
+    for (Flag_group* flagGroup : { &first, &second }) {
+        SchedulingManager manager(*flagGroup, true, SchedulingManager::NoRule);
+        manager.setSeed(seed); // 种子相同，键只差在队员数据
+        manager.schedule();
+        for (const QString& violation : manager.checkInvariants()) {
+            fail("排班结果缓存的键发生冲突：" + violation);
+        }
+    }
+    qInfo().noquote() << "排班结果缓存键检查完成";
+}
+
+// 正常的队员数据行，编号为id；wide为true时在默认4行 × 5列以外也有空，数据行多出完整的执勤时间位字段
+QByteArray validLine(int id, bool wide = false) {
+    bool time[Person::maxTimeRows][Person::maxDays] = {};
+    for (int row = 0; row < (wide ? Person::maxTimeRows : 4); ++row) {
+        for (int day = 0; day < (wide ? Person::maxDays : 5); ++day) {
+            time[row][day] = (row + day + id) % 2 == 0;
+        }
+    }
+    Person person("正常" + std::to_string(id), id % 2 == 1, id % 4 + 1, "13800000000", "湖北", "汉族", "东院1-101", "理学院",
+                  "数学2301", "2004-01-01", true, time, 1, 5);
+    person.setId(id);
+    return FlagGroupFileManager::recordOf(person);
+}
+
+// 把正常数据行的第field个字段（从0起）替换为value
+QByteArray withField(const QByteArray& line, int field, const QByteArray& value) {
+    QList<QByteArray> parts = line.split('|');
+    parts[field] = value;
+    return parts.join('|');
+}
+
+// 错误数据行集合，每一行都必须整行丢弃
+QList<QByteArray> malformedLines() {
+    const QByteArray line = validLine(1000);
+    const QList<QByteArray> fields = line.split('|');
+    QList<QByteArray> lines;
+    lines << ""; // 空行
+    lines << "|"; // 只有分隔号
+    lines << QByteArray(32, '|'); // 字段数为33但全部为空
+    lines << "这不是队员数据";
+    lines << fields.mid(0, 32).join('|'); // 少一个字段
+    lines << line + "|7"; // 多一个字段，执勤时间位都在默认4行 × 5列以内
+    lines << line + "|7|8"; // 多两个字段
+    lines << line + "|7|8|9"; // 多三个字段
+    const QByteArray wideLine = validLine(1001, true);
+    lines << withField(wideLine, 34, "zz"); // 执勤时间位不是十六进制数
+    lines << withField(wideLine, 34, "ffffffffffffffff"); // 超出执勤时间表的容量
+    lines << withField(wideLine, 11, wideLine.split('|')[11] == "1" ? "0" : "1"); // 与默认4行 × 5列的字段不一致
+    lines << withField(line, 1, "2"); // 性别不是0/1
+    lines << withField(line, 1, "男");
+    lines << withField(line, 1, ""); // 性别为空
+    lines << withField(line, 2, "0"); // 组别不在1~4
+    lines << withField(line, 2, "5");
+    lines << withField(line, 2, "-1");
+    lines << withField(line, 2, "一组");
+    lines << withField(line, 10, "2"); // 是否参与排班不是0/1
+    lines << withField(line, 11, "x"); // 执勤时间不是0/1
+    lines << withField(line, 30, "-1");
+    lines << withField(line, 30, "");
+    lines << withField(line, 31, "-3"); // 本次执勤次数为负数
+    lines << withField(line, 31, "1.5");
+    lines << withField(line, 32, "-1"); // 总执勤次数为负数
+    lines << withField(line, 32, "99999999999"); // 超出int范围
+    lines << withField(line, 33, "-7"); // 编号为负数
+    lines << withField(line, 33, "abc");
+    return lines;
+}
+
+// 错误数据行必须被parseLine拒绝，正常数据行必须被接受
+void testParseLine() {
+    const QList<QByteArray> lines = malformedLines();
+    for (const QByteArray& line : lines) {
+        Person person;
+        if (FlagGroupFileManager::parseLine(QString::fromUtf8(line), person)) {
+            fail("parseLine接受了错误数据行：" + QString::fromUtf8(line));
+        }
+    }
+    Person person;
+    if (!FlagGroupFileManager::parseLine(QString::fromUtf8(validLine(1)), person) || person.getId() != 1) {
+        fail("parseLine拒绝了正常数据行");
+    }
+    // 默认4行 × 5列以外的执勤时间原样读回，写出的数据行与读入的相同
+    const QByteArray wideLine = validLine(3, true);
+    if (wideLine.split('|').size() != 35) {
+        fail("4行 × 5列以外的执勤时间没有写出");
+    }
+    if (!FlagGroupFileManager::parseLine(QString::fromUtf8(wideLine), person) || person.getId() != 3
+        || FlagGroupFileManager::recordOf(person) != wideLine) {
+        fail("parseLine没有原样读回4行 × 5列以外的执勤时间：" + QString::fromUtf8(wideLine));
+    }
+    // 旧版数据文件没有编号字段
+    QList<QByteArray> fields = validLine(2).split('|');
+    fields.removeLast();
+    if (!FlagGroupFileManager::parseLine(QString::fromUtf8(fields.join('|')), person) || person.getId() != 0) {
+        fail("parseLine拒绝了没有编号的旧版数据行");
+    }
+    qInfo().noquote() << QString("数据行解析检查：%1行错误数据").arg(lines.size());
+}
+
+// 错误数据行与正常数据行交错写入文件，只读出正常的队员；重复编号与没有编号的队员分配新编号，编号互不重复
+void testLoadFromFile() {
+    QTemporaryDir directory;
+    if (!directory.isValid()) {
+        fail("无法创建临时目录");
+        return;
+    }
+    const QString filename = directory.filePath("data.txt");
+    const QList<QByteArray> lines = malformedLines();
+    QByteArray content;
+    int expected = 0;
+    for (int i = 0; i < lines.size(); ++i) {
+        content += validLine(i + 1) + "\n";
+        content += lines[i] + (i % 2 ? "\r\n" : "\n"); // 两种换行符都要处理
+        ++expected;
+    }
+    QList<QByteArray> legacy = validLine(500).split('|');
+    legacy.removeLast();
+    content += legacy.join('|') + "\n"; // 没有编号的旧版数据行
+    content += validLine(1) + "\n"; // 与第一行编号重复
+    content += validLine(900); // 最后一行没有换行符
+    expected += 3;
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly) || file.write(content) != content.size()) {
+        fail("无法写入测试数据文件");
+        return;
+    }
+    file.close();
+
+    for (bool lazyProfiles : { true, false }) {
+        Flag_group flagGroup;
+        FlagGroupFileManager::loadFromFile(flagGroup, filename, lazyProfiles);
+        int loaded = 0;
+        std::unordered_set<int> ids;
+        for (int group = 1; group <= 4; ++group) {
+            for (const Person& person : flagGroup.getGroupMembers(group)) {
+                ++loaded;
+                if (person.getId() <= 0 || !ids.insert(person.getId()).second) {
+                    fail(QString("loadFromFile读出的队员编号无效或重复：%1").arg(person.getId()));
+                }
+                if (person.getName().rfind("正常", 0) != 0) {
+                    fail("loadFromFile读出了错误数据行：" + QString::fromStdString(person.getName()));
+                }
+                if (person.getPhone_number() != "13800000000") {
+                    fail("loadFromFile读出的档案信息不正确：" + QString::fromStdString(person.getName()));
+                }
+            }
+        }
+        if (loaded != expected) {
+            fail(QString("loadFromFile读出%1名队员，应为%2名（延迟读取档案：%3）").arg(loaded).arg(expected).arg(lazyProfiles));
+        }
+    }
+    qInfo().noquote() << "数据文件读取检查完成";
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    bool ok = true;
+    int runs = argc > 1 ? QString(argv[1]).toInt(&ok) : 3000;
+    if (!ok || runs < 0) {
+        qCritical() << "用法：schedulerTest [排班次数] [起始种子]";
+        return 2;
+    }
+    quint64 firstSeed = argc > 2 ? QString(argv[2]).toULongLong(&ok) : 1;
+    if (!ok) {
+        qCritical() << "用法：schedulerTest [排班次数] [起始种子]";
+        return 2;
+    }
+    testSchedulingInvariants(runs, firstSeed);
+    testCacheKeyCollision(firstSeed);
+    testParseLine();
+    testLoadFromFile();
+    if (failures > 0) {
+        qCritical().noquote() << QString("共%1项检查失败").arg(failures);
+        return 1;
+    }
+    qInfo() << "全部通过";
+    return 0;
+}
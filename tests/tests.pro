@@ -0,0 +1,25 @@
+# tests.pro
+# 排班规则与数据文件读取的独立测试程序schedulerTest，只依赖Qt Core，不依赖界面
+# 构建与运行：在tests目录下 qmake && make && make check（make check 以默认参数运行schedulerTest，失败时返回非0）
+
+QT = core
+CONFIG += console c++17 testcase
+CONFIG -= app_bundle
+
+TARGET = schedulerTest
+INCLUDEPATH += ..
+
+SOURCES += \
+    schedulerTest.cpp \
+    ../Person.cpp \
+    ../Flag_group.cpp
+
+# dataFunction.h中的SchedulingManager带有Q_OBJECT，需要列在HEADERS中经过moc处理
+HEADERS += \
+    ../Person.h \
+    ../Flag_group.h \
+    ../traceFunction.h \
+    ../cacheFunction.h \
+    ../siteFunction.h \
+    ../dataFunction.h \
+    ../fileFunction.h
@@ -0,0 +1,146 @@
+// traceFunction.h头文件
+// 功能说明：界面耗时追踪UiTracer，记录界面槽函数、其中执行的花名册操作以及界面重绘的耗时，写出Chrome追踪格式（JSON），
+// 可在chrome://tracing或Perfetto（ui.perfetto.dev）中按时间轴查看一次点击的时间都花在了哪里
+// 设置环境变量FLAG_GROUP_TRACE为输出文件名时启用，窗口关闭时写出；未设置时每个追踪点只检查一次开关，不取时间、不加锁，
+// 正式版本中也可以保留
+//
+// 追踪点用TraceScope在函数开头声明，离开作用域时记录一个完整事件（"ph":"X"），同一线程中嵌套的事件在时间轴上自动嵌套显示
+// 只使用标准库，Flag_group等不依赖Qt的代码也可以直接使用
+
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// UiTracer 类定义，界面耗时追踪，全程序一个实例
+class UiTracer
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static UiTracer& instance() {
+        static UiTracer tracer;
+        return tracer;
+    }
+    bool isEnabled() const { return enabled; }
+
+    // 记录一个事件。参数：name：事件名称。category：分类，如slot、roster、model、paint。start、end：开始与结束时间
+    void record(std::string name, const char* category, Clock::time_point start, Clock::time_point end) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (events.size() >= maxEvents) {
+            ++dropped; // 超过上限后不再记录，避免长时间运行时占用过多内存
+            return;
+        }
+        events.push_back({std::move(name), category, micros(start), micros(end) - micros(start), threadIndex()});
+    }
+    // 写出追踪文件，返回是否成功；未启用时不写出
+    bool write() {
+        if (!enabled) {
+            return false;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        std::ofstream file(filename, std::ios::binary | std::ios::trunc);
+        if (!file) {
+            return false;
+        }
+        file << "{\"traceEvents\":[\n";
+        char number[64];
+        for (size_t i = 0; i < events.size(); ++i) {
+            const Event& event = events[i];
+            file << "{\"name\":\"" << escaped(event.name) << "\",\"cat\":\"" << event.category << "\",\"ph\":\"X\"";
+            std::snprintf(number, sizeof(number), ",\"ts\":%.3f,\"dur\":%.3f", event.start, event.duration);
+            file << number << ",\"pid\":1,\"tid\":" << event.thread << "}" << (i + 1 < events.size() ? ",\n" : "\n");
+        }
+        file << "],\"displayTimeUnit\":\"ms\",\"otherData\":{\"droppedEvents\":" << dropped << "}}\n";
+        return static_cast<bool>(file);
+    }
+
+private:
+    // 一个完整事件
+    struct Event {
+        std::string name; // 名称
+        const char* category; // 分类
+        double start; // 开始时间，自启动起的微秒数
+        double duration; // 耗时（微秒）
+        int thread; // 线程编号，界面线程通常为1
+    };
+    static constexpr size_t maxEvents = 2000000; // 最多记录的事件数
+
+    bool enabled = false; // 是否启用
+    std::string filename; // 输出文件名
+    Clock::time_point origin = Clock::now(); // 启动时间
+    std::mutex mutex; // 保护以下成员，后台线程（排班、保存）中的花名册操作也会被记录
+    std::vector<Event> events; // 已记录的事件
+    std::unordered_map<std::thread::id, int> threads; // 线程 -> 线程编号，按首次出现的顺序从1编号
+    long long dropped = 0; // 超过上限而未记录的事件数
+
+    UiTracer() {
+        const char* path = std::getenv("FLAG_GROUP_TRACE");
+        if (path && *path) {
+            enabled = true;
+            filename = path;
+            events.reserve(65536);
+        }
+    }
+    double micros(Clock::time_point time) const {
+        return std::chrono::duration<double, std::micro>(time - origin).count();
+    }
+    int threadIndex() {
+        auto it = threads.find(std::this_thread::get_id());
+        if (it == threads.end()) {
+            it = threads.emplace(std::this_thread::get_id(), static_cast<int>(threads.size()) + 1).first;
+        }
+        return it->second;
+    }
+    // 名称中的引号、反斜杠与控制字符按JSON规则转义
+    static std::string escaped(const std::string& text) {
+        std::string result;
+        result.reserve(text.size());
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                result += '\\';
+                result += c;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                char code[8];
+                std::snprintf(code, sizeof(code), "\\u%04x", static_cast<unsigned char>(c));
+                result += code;
+            } else {
+                result += c;
+            }
+        }
+        return result;
+    }
+};
+
+// TraceScope 类定义，追踪点：构造时记下开始时间，析构时记录一个事件。未启用追踪时什么也不做
+class TraceScope
+{
+public:
+    // 参数：name：事件名称，须为字符串常量。category：分类，须为字符串常量
+    TraceScope(const char* name, const char* category) : name(name), category(category) {
+        if (UiTracer::instance().isEnabled()) {
+            active = true;
+            start = UiTracer::Clock::now();
+        }
+    }
+    ~TraceScope() {
+        if (active) {
+            UiTracer::instance().record(name, category, start, UiTracer::Clock::now());
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    const char* category;
+    bool active = false;
+    UiTracer::Clock::time_point start;
+};
@@ -0,0 +1,156 @@
+// undoFunction.h头文件
+// 功能说明：提供花名册的撤销/重做功能RosterUndoStack
+// 每次修改队员信息前只记下这次修改涉及的队员：编号、所在组别与行号，以及修改前的信息。
+// Person采用写时复制，记下的信息只复制数据指针，因此记录的开销只与涉及的队员数成正比，与花名册大小无关
+// 新增的队员没有修改前的状态，只记编号，撤销时删除
+// 撤销、重做时先记下这些队员当前的状态作为反方向的记录，再按编号移除并插回原位，需要遍历一次花名册
+// 修改花名册之外还改动了其他数据的操作（如制表同时写入执勤历史）可附带撤销、重做时执行的操作，与花名册一起撤销
+
+#pragma once
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <unordered_set>
+#include <vector>
+#include "Flag_group.h"
+
+// RosterUndoStack 类定义，撤销/重做栈
+class RosterUndoStack
+{
+public:
+    // 构造函数
+    // 参数：size_t limit：最多保留的撤销步数，超出后丢弃最早的记录
+    explicit RosterUndoStack(size_t limit = 50) : limit(limit) {}
+
+    // 撤销、重做一条记录时一并执行的操作。参数：redo：true为重做，false为撤销
+    using SideEffect = std::function<void(bool redo)>;
+
+    // 修改前调用，记下将被修改、删除或换组的队员，并清空重做记录
+    // 参数：members：花名册中的队员，新增队员时为空，新增后再调用recordAdded。effect：该次修改附带的其他改动的撤销与重做，没有时为空
+    void recordMembers(const Flag_group& current, const std::vector<const Person*>& members, SideEffect effect = nullptr) {
+        Entry entry;
+        entry.effect = std::move(effect);
+        std::less<const Person*> before;
+        for (const Person* member : members) {
+            // 按地址找出队员所在的组与行，不在花名册中的队员不记录
+            for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+                const auto& groupMembers = current.getGroupMembers(groupNumber);
+                if (!groupMembers.empty() && !before(member, groupMembers.data()) && before(member, groupMembers.data() + groupMembers.size())) {
+                    entry.ids.push_back(member->getId());
+                    entry.memberSlots.push_back({groupNumber, static_cast<size_t>(member - groupMembers.data()), *member});
+                    break;
+                }
+            }
+        }
+        std::sort(entry.memberSlots.begin(), entry.memberSlots.end(), [](const Flag_group::MemberSlot& a, const Flag_group::MemberSlot& b) {
+            return a.groupNumber != b.groupNumber ? a.groupNumber < b.groupNumber : a.row < b.row;
+        });
+        push(std::move(entry));
+    }
+    // 整组修改前调用，记下该组全部队员
+    void recordGroup(const Flag_group& current, int groupNumber) {
+        const auto& groupMembers = current.getGroupMembers(groupNumber);
+        std::vector<const Person*> members;
+        members.reserve(groupMembers.size());
+        for (const Person& member : groupMembers) {
+            members.push_back(&member);
+        }
+        recordMembers(current, members);
+    }
+    // 涉及全体队员的修改（如执勤次数归零、制表写回执勤次数）前调用，记下全部队员
+    void recordAll(const Flag_group& current, SideEffect effect = nullptr) {
+        Entry entry;
+        entry.effect = std::move(effect);
+        captureInto(current, nullptr, entry);
+        push(std::move(entry));
+    }
+    // 新增队员后调用，最近一条记录再记下groupNumber组末尾的count名新队员，撤销时删除
+    void recordAdded(const Flag_group& current, int groupNumber, size_t count) {
+        if (undoEntries.empty()) {
+            return;
+        }
+        const auto& groupMembers = current.getGroupMembers(groupNumber);
+        count = std::min(count, groupMembers.size());
+        for (size_t row = groupMembers.size() - count; row < groupMembers.size(); ++row) {
+            undoEntries.back().ids.push_back(groupMembers[row].getId());
+        }
+    }
+    // 撤销：恢复最近一次修改前的队员，当前状态存入重做记录。没有可撤销的记录时返回false
+    bool undo(Flag_group& current) {
+        if (undoEntries.empty()) {
+            return false;
+        }
+        Entry entry = std::move(undoEntries.back());
+        undoEntries.pop_back();
+        redoEntries.push_back(restore(current, entry));
+        if (entry.effect) {
+            entry.effect(false);
+        }
+        return true;
+    }
+    // 重做：恢复最近一次被撤销的修改，当前状态存入撤销记录。没有可重做的记录时返回false
+    bool redo(Flag_group& current) {
+        if (redoEntries.empty()) {
+            return false;
+        }
+        Entry entry = std::move(redoEntries.back());
+        redoEntries.pop_back();
+        undoEntries.push_back(restore(current, entry));
+        if (entry.effect) {
+            entry.effect(true);
+        }
+        return true;
+    }
+    bool canUndo() const { return !undoEntries.empty(); }
+    // 清空撤销与重做记录
+    void clear() {
+        undoEntries.clear();
+        redoEntries.clear();
+    }
+    bool canRedo() const { return !redoEntries.empty(); }
+
+private:
+    // 一条撤销或重做记录
+    struct Entry {
+        std::vector<int> ids; // 涉及的队员编号，包括当时不在花名册中的队员
+        std::vector<Flag_group::MemberSlot> memberSlots; // 当时在花名册中的队员，按组别、行号升序
+        SideEffect effect; // 附带的其他改动
+    };
+
+    size_t limit; // 最多保留的撤销步数
+    std::deque<Entry> undoEntries; // 撤销记录，末尾为最近一次修改
+    std::deque<Entry> redoEntries; // 重做记录，末尾为最近一次撤销
+
+    void push(Entry&& entry) {
+        undoEntries.push_back(std::move(entry));
+        if (undoEntries.size() > limit) {
+            undoEntries.pop_front();
+        }
+        redoEntries.clear();
+    }
+    // 遍历花名册，把编号在ids中的队员（ids为空指针时为全部队员）按组别、行号顺序记入entry
+    static void captureInto(const Flag_group& current, const std::unordered_set<int>* ids, Entry& entry) {
+        for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+            const auto& groupMembers = current.getGroupMembers(groupNumber);
+            for (size_t row = 0; row < groupMembers.size(); ++row) {
+                if (!ids || ids->count(groupMembers[row].getId())) {
+                    if (!ids) {
+                        entry.ids.push_back(groupMembers[row].getId());
+                    }
+                    entry.memberSlots.push_back({groupNumber, row, groupMembers[row]});
+                }
+            }
+        }
+    }
+    // 把entry中的队员恢复到花名册，返回恢复前这些队员的状态，作为反方向的记录
+    static Entry restore(Flag_group& current, const Entry& entry) {
+        Entry inverse;
+        inverse.ids = entry.ids;
+        inverse.effect = entry.effect;
+        std::unordered_set<int> ids(entry.ids.begin(), entry.ids.end());
+        captureInto(current, &ids, inverse);
+        current.restoreMembers(ids, entry.memberSlots);
+        return inverse;
+    }
+};
@@ -0,0 +1,149 @@
+// unitFunction.h头文件
+// 功能说明：多单位并行排班MultiUnitScheduler
+// 规模较大时会有多个相互独立的单位（各自的花名册、执勤地点与排班规则），单位之间没有共同队员，可以同时排班
+// 每个单位作为一个任务交给线程池，空闲线程从共同的任务队列中取下一个单位，排得快的线程自动多排几个，
+// 总耗时取决于CPU核数而不是单位数；全部完成后按输入顺序合并结果
+//
+// 单位目录：每个单位一个目录，包含data.txt（队员数据，格式与主程序相同），可选sites.txt（执勤地点与仪式配置）
+// 与rules.txt（一行，可包含TOTAL、MONDAY或ALL、SEED 种子，与花名册服务的SCHEDULE请求相同）
+
+#pragma once
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QStringList>
+#include <QThreadPool>
+#include <QtConcurrent/QtConcurrent>
+#include <memory>
+#include <vector>
+#include "Flag_group.h"
+#include "fileFunction.h"
+#include "dataFunction.h"
+#include "siteFunction.h"
+
+// 一个排班单位
+struct SchedulingUnit
+{
+    QString name; // 单位名称
+    Flag_group roster; // 花名册
+    SiteRegistry registry; // 执勤地点与仪式登记表
+    bool useTotalTimesRule = false; // 是否采用总次数规则
+    SchedulingManager::HandoverRule handoverRule = SchedulingManager::NoRule; // 交接规则
+    bool hasSeed = false; // 是否指定了随机数种子，指定时排班结果可复现并会被缓存
+    quint64 seed = 0; // 随机数种子
+};
+
+// 一个单位的排班结果
+struct UnitResult
+{
+    QString name; // 单位名称
+    std::shared_ptr<Flag_group> roster; // 排班后的花名册（执勤次数已更新），工作表格中的队员指针指向其中的队员
+    ScheduleTable table; // 工作表格
+    QStringList warnings; // 排班警告
+    SiteRegistry registry; // 该单位的执勤地点与仪式登记表
+};
+
+// MultiUnitScheduler 类定义，多单位并行排班
+class MultiUnitScheduler
+{
+public:
+    // 读取单位目录，目录中没有data.txt时返回false
+    static bool loadUnit(const QString& directory, SchedulingUnit& unit) {
+        QDir dir(directory);
+        if (!dir.exists("data.txt")) {
+            return false;
+        }
+        unit.name = QFileInfo(directory).fileName();
+        FlagGroupFileManager::loadFromFile(unit.roster, dir.filePath("data.txt"));
+        unit.registry.load(dir.filePath("sites.txt"));
+        QFile rules(dir.filePath("rules.txt"));
+        if (rules.open(QIODevice::ReadOnly | QIODevice::Text)) {
+            QStringList options = QTextStream(&rules).readLine().toUpper().split(' ', Qt::SkipEmptyParts);
+            unit.useTotalTimesRule = options.contains("TOTAL");
+            if (options.contains("MONDAY")) {
+                unit.handoverRule = SchedulingManager::MondayHandoverRule;
+            } else if (options.contains("ALL")) {
+                unit.handoverRule = SchedulingManager::AllHandoverRule;
+            }
+            int seedIndex = options.indexOf("SEED");
+            if (seedIndex >= 0 && seedIndex + 1 < options.size()) {
+                unit.hasSeed = true;
+                unit.seed = options[seedIndex + 1].toULongLong();
+            }
+        }
+        return true;
+    }
+
+    // 并行排班，返回结果的顺序与units一致
+    // 参数：QThreadPool：执行排班的线程池，默认为全局线程池（线程数等于CPU核数）
+    static std::vector<UnitResult> scheduleAll(const std::vector<SchedulingUnit>& units,
+                                               QThreadPool* pool = QThreadPool::globalInstance()) {
+        std::vector<UnitResult> results(units.size());
+        std::vector<int> indexes(units.size());
+        for (size_t i = 0; i < indexes.size(); ++i) {
+            indexes[i] = static_cast<int>(i);
+        }
+        // 每个单位一个任务，由线程池按空闲情况分配
+        QtConcurrent::blockingMap(pool, indexes, [&units, &results](int index) {
+            results[index] = scheduleUnit(units[index]);
+        });
+        return results;
+    }
+
+    // 合并各单位的排班结果为文本报告，各单位依次列出工作表格、执勤次数与警告
+    static QString merge(const std::vector<UnitResult>& results) {
+        QString report;
+        for (const UnitResult& result : results) {
+            report += "【" + result.name + "】\n";
+            for (int slot = 0; slot < result.table.slotCount(); ++slot) {
+                for (int location = 0; location < result.table.siteCount(); ++location) {
+                    QStringList names;
+                    for (Person* person : result.table.crew(slot, location)) {
+                        if (person) {
+                            names << QString::fromStdString(person->getName());
+                        }
+                    }
+                    int dayIndex = result.registry.slotDay(slot) - 1;
+                    report += result.registry.dayName(dayIndex) + " " + result.registry.rowLabel(result.registry.timeRow(slot, location))
+                              + "：" + names.join(" ") + "\n";
+                }
+            }
+            for (int groupNumber = 1; groupNumber <= 4; ++groupNumber) {
+                for (const auto& member : result.roster->getGroupMembers(groupNumber)) {
+                    if (member.getIsWork()) {
+                        report += QString::fromStdString(member.getName()) + " 的工作次数: " + QString::number(member.getTimes())
+                                  + " 总工作次数: " + QString::number(member.getAll_times()) + "\n";
+                    }
+                }
+            }
+            for (const QString& warning : result.warnings) {
+                report += warning + "\n";
+            }
+            report += "\n";
+        }
+        return report;
+    }
+
+private:
+    // 排一个单位，在工作线程中执行
+    // 排班结果写入排班管理器的花名册快照，快照与输入共用未修改的队员数据（写时复制），不影响输入的单位
+    static UnitResult scheduleUnit(const SchedulingUnit& unit) {
+        UnitResult result;
+        result.name = unit.name;
+        result.registry = unit.registry;
+        SchedulingManager manager(unit.roster, unit.useTotalTimesRule, unit.handoverRule, result.registry);
+        if (unit.hasSeed) {
+            manager.setSeed(unit.seed);
+        }
+        // 未指定接收对象，警告在当前工作线程中直接处理
+        QObject::connect(&manager, &SchedulingManager::schedulingWarning, [&result](const QString& warning) {
+            result.warnings << warning;
+        });
+        manager.schedule();
+        result.roster = manager.getScheduledRoster(); // 保持快照，工作表格中的队员指针才有效
+        result.table = manager.getScheduleTable();
+        return result;
+    }
+};